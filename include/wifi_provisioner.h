@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "esp_netif_types.h"
+#include "esp_wifi_types.h"
 #include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
@@ -24,6 +25,93 @@ typedef void (*wifi_prov_on_connected_cb_t)(void);
  */
 typedef void (*wifi_prov_on_portal_start_cb_t)(void);
 
+/**
+ * How credentials are received when no stored network works.
+ */
+typedef enum {
+    WIFI_PROV_TRANSPORT_HTTP,   /* soft-AP with captive portal */
+    WIFI_PROV_TRANSPORT_BLE,    /* GATT service, needs CONFIG_WIFI_PROV_TRANSPORT_BLE */
+} wifi_prov_transport_t;
+
+/**
+ * Key provider for encrypted credential storage
+ * (CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS). Must fill @p key with 32 bytes
+ * of device-unique key material. Called at most once per boot.
+ */
+typedef esp_err_t (*wifi_prov_key_provider_t)(uint8_t key[32]);
+
+/**
+ * What the provisioner has the radio doing. Times are per state as set
+ * by the provisioner (policy), not measured sleep.
+ */
+typedef enum {
+    WIFI_PROV_RADIO_OFF,          /* driver not running */
+    WIFI_PROV_RADIO_SEARCHING,    /* connecting, or listening for shared credentials */
+    WIFI_PROV_RADIO_PORTAL,       /* provisioning transport up, radio awake */
+    WIFI_PROV_RADIO_ACTIVE,       /* connected, power save off */
+    WIFI_PROV_RADIO_POWER_SAVE,   /* connected, modem power save on */
+    WIFI_PROV_RADIO_STATE_MAX,
+} wifi_prov_radio_state_t;
+
+typedef struct {
+    wifi_prov_radio_state_t state;                              /* current */
+    uint64_t                time_ms[WIFI_PROV_RADIO_STATE_MAX]; /* since boot */
+} wifi_prov_radio_stats_t;
+
+/**
+ * A scanned network (strongest AP seen for that SSID).
+ */
+typedef struct {
+    char             ssid[33];
+    uint8_t          bssid[6];
+    uint8_t          channel;
+    int8_t           rssi;
+    wifi_auth_mode_t authmode;
+} wifi_prov_network_t;
+
+/**
+ * Result filter for wifi_prov_scan_async().
+ * Use WIFI_PROV_SCAN_FILTER_DEFAULT() to accept everything.
+ */
+typedef struct {
+    int8_t           min_rssi;      /* weakest signal included */
+    wifi_auth_mode_t min_authmode;  /* weakest auth mode included */
+    const char      *ssid_prefix;   /* NULL = any SSID */
+    uint16_t         max_results;   /* strongest K matches, 0 = all */
+    uint32_t         max_age_ms;    /* reuse cached results this fresh, 0 = always scan */
+    bool             show_hidden;   /* include hidden APs (empty SSID, one per BSSID) */
+} wifi_prov_scan_filter_t;
+
+#define WIFI_PROV_SCAN_FILTER_DEFAULT() {                                   \
+    .min_rssi     = -127,                                                   \
+    .min_authmode = WIFI_AUTH_OPEN,                                         \
+    .ssid_prefix  = NULL,                                                   \
+    .max_results  = 0,                                                      \
+    .max_age_ms   = 0,                                                      \
+    .show_hidden  = false,                                                  \
+}
+
+/**
+ * Scan completion callback. @p networks is sorted strongest first and
+ * only valid during the call. Runs in the default event loop task.
+ */
+typedef void (*wifi_prov_scan_cb_t)(esp_err_t status,
+                                    const wifi_prov_network_t *networks,
+                                    uint16_t count, void *arg);
+
+/**
+ * Portal page text, see wifi_prov_set_branding(). Same meaning as the
+ * matching wifi_prov_config_t fields; HTML entities are supported.
+ */
+typedef struct {
+    const char *page_title;
+    const char *portal_header;
+    const char *portal_subheader;
+    const char *connected_header;
+    const char *connected_subheader;
+    const char *page_footer;
+} wifi_prov_branding_t;
+
 /**
  * Provisioner configuration.
  * Use WIFI_PROV_DEFAULT_CONFIG() to initialise with Kconfig defaults.
@@ -31,17 +119,25 @@ typedef void (*wifi_prov_on_portal_start_cb_t)(void);
 typedef struct {
     const char *ap_ssid;
     const char *ap_password;
-    uint8_t     ap_channel;
+    uint8_t     ap_channel;              /* 0 = automatic */
     uint8_t     ap_max_connections;
     uint8_t     max_retries;
     uint16_t    portal_timeout;          /* seconds, 0 = no timeout */
     uint16_t    http_port;
+    wifi_prov_transport_t transport;
     const char *page_title;
     const char *portal_header;
     const char *portal_subheader;
     const char *connected_header;
     const char *connected_subheader;
     const char *page_footer;
+    wifi_auth_mode_t      sta_min_authmode;  /* weakest auth mode accepted */
+    bool                  sta_pmf_required;  /* refuse APs without PMF */
+    wifi_sae_pwe_method_t sta_sae_pwe;       /* WPA3 SAE PWE derivation */
+    wifi_ps_type_t        sta_ps_mode;       /* once connected; no NONE with BT */
+    uint16_t              sta_listen_interval; /* beacons, max modem PS */
+    uint16_t              ap_beacon_interval;  /* TU, while the portal runs */
+    uint16_t              ap_inactive_time;    /* seconds before idle clients drop */
     wifi_prov_on_connected_cb_t    on_connected;
     wifi_prov_on_portal_start_cb_t on_portal_start;
 } wifi_prov_config_t;
@@ -54,12 +150,20 @@ typedef struct {
     .max_retries       = CONFIG_WIFI_PROV_STA_MAX_RETRIES,                  \
     .portal_timeout    = CONFIG_WIFI_PROV_PORTAL_TIMEOUT,                   \
     .http_port         = CONFIG_WIFI_PROV_HTTP_PORT,                        \
+    .transport         = WIFI_PROV_TRANSPORT_HTTP,                          \
     .page_title        = CONFIG_WIFI_PROV_PAGE_TITLE,                      \
     .portal_header     = CONFIG_WIFI_PROV_PORTAL_HEADER,                   \
     .portal_subheader  = CONFIG_WIFI_PROV_PORTAL_SUBHEADER,                \
     .connected_header  = CONFIG_WIFI_PROV_CONNECTED_HEADER,                \
     .connected_subheader = CONFIG_WIFI_PROV_CONNECTED_SUBHEADER,           \
     .page_footer       = CONFIG_WIFI_PROV_PAGE_FOOTER,                     \
+    .sta_min_authmode  = (wifi_auth_mode_t)CONFIG_WIFI_PROV_STA_MIN_AUTHMODE, \
+    .sta_pmf_required  = false,                                             \
+    .sta_sae_pwe       = WPA3_SAE_PWE_BOTH,                                 \
+    .sta_ps_mode       = (wifi_ps_type_t)CONFIG_WIFI_PROV_STA_PS_MODE,      \
+    .sta_listen_interval = CONFIG_WIFI_PROV_STA_LISTEN_INTERVAL,           \
+    .ap_beacon_interval = CONFIG_WIFI_PROV_AP_BEACON_INTERVAL,             \
+    .ap_inactive_time  = CONFIG_WIFI_PROV_AP_INACTIVE_TIME,                 \
     .on_connected      = NULL,                                              \
     .on_portal_start   = NULL,                                              \
 }
@@ -77,11 +181,15 @@ esp_err_t wifi_prov_init(void);
  * Calls wifi_prov_init() automatically if not already done.
  * Reads stored credentials from NVS and attempts to connect.
  * Falls back to AP + captive portal on failure.
+ * Does nothing if already started; call wifi_prov_stop() first to
+ * restart with a different configuration.
  */
 esp_err_t wifi_prov_start(const wifi_prov_config_t *config);
 
 /**
- * Stop the WiFi provisioner and release all resources.
+ * Stop the WiFi provisioner and release all resources, including the
+ * WiFi driver and its netifs. Safe to call when not started. Start and
+ * stop can be repeated any number of times.
  */
 esp_err_t wifi_prov_stop(void);
 
@@ -93,11 +201,93 @@ esp_err_t wifi_prov_stop(void);
  */
 esp_err_t wifi_prov_wait_for_connection(TickType_t timeout_ticks);
 
+/**
+ * Open the provisioning portal while staying connected, to move the
+ * device to another network without a reboot. The portal runs next to
+ * the STA link (APSTA, on the uplink's channel). Submitted credentials
+ * are tried in place of the current ones. If they work they are saved
+ * and the portal closes, as with wifi_prov_start(). If not, the previous
+ * network is reconnected and the stored credentials stay untouched.
+ *
+ * The radio has a single station interface, so the uplink is down while
+ * the new network is tried: one attempt, cut off after 15 s, plus the
+ * reconnect to the previous network if it fails. A network that did not
+ * show up in the portal's scan is refused without leaving the current
+ * one, unless it is pinned by BSSID or channel (hidden networks).
+ *
+ * @return ESP_ERR_INVALID_STATE if not connected,
+ *         ESP_OK if the portal is (already) open.
+ */
+esp_err_t wifi_prov_open_portal(void);
+
+/**
+ * Close a portal opened with wifi_prov_open_portal() without changing
+ * networks. The STA link is not affected.
+ */
+esp_err_t wifi_prov_close_portal(void);
+
 /**
  * Erase stored WiFi credentials from NVS.
  */
 esp_err_t wifi_prov_erase_credentials(void);
 
+/**
+ * Override the key provider used to encrypt stored credentials.
+ * Must be called before wifi_prov_start(). Pass NULL to restore the
+ * default (HMAC peripheral with the configured eFuse key block).
+ */
+esp_err_t wifi_prov_set_key_provider(wifi_prov_key_provider_t provider);
+
+/**
+ * Broadcast the stored credentials to unprovisioned peers over ESP-NOW
+ * (CONFIG_WIFI_PROV_ESPNOW). Blocks for duration_ms while sending.
+ * Requires an established station connection. If the application has
+ * ESP-NOW initialised already, that instance is used and left running
+ * with its peers and callbacks; otherwise ESP-NOW is brought up for the
+ * broadcast and deinitialised after it.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED if ESP-NOW sharing is disabled,
+ *         ESP_ERR_INVALID_STATE if not connected.
+ */
+esp_err_t wifi_prov_share_credentials(uint32_t duration_ms);
+
+/**
+ * Replace the portal page text. Takes effect for the next page load,
+ * also while the portal is running. Called before wifi_prov_start(), it
+ * overrides the text in the config passed there, for that start and
+ * later ones. NULL or empty subheaders and footer are hidden. The
+ * strings must stay valid while the provisioner runs, like those in
+ * wifi_prov_config_t.
+ */
+esp_err_t wifi_prov_set_branding(const wifi_prov_branding_t *branding);
+
+/**
+ * Scan for networks without blocking. Requests made while a scan is in
+ * flight share its result, and results younger than filter->max_age_ms
+ * are answered from the cache (then @p cb runs before this returns).
+ * The WiFi driver must be started in STA or APSTA mode.
+ *
+ * @param filter  Result filter, or NULL for all networks.
+ * @return ESP_ERR_NO_MEM if too many requests are pending.
+ */
+esp_err_t wifi_prov_scan_async(const wifi_prov_scan_filter_t *filter,
+                               wifi_prov_scan_cb_t cb, void *arg);
+
+/**
+ * Write the event counters and the most recent events as JSON
+ * (CONFIG_WIFI_PROV_STATS), the same document /debug/events serves.
+ * Output is truncated to fit; like snprintf, returns the full length
+ * (0 when the event log is disabled). Safe to call from any task.
+ */
+size_t wifi_prov_dump_events(char *buf, size_t len);
+
+/**
+ * Time spent in each radio state since boot, including the current one
+ * up to now. Compare the POWER_SAVE and PORTAL shares against current
+ * measurements to tune the power fields of wifi_prov_config_t.
+ */
+esp_err_t wifi_prov_get_radio_stats(wifi_prov_radio_stats_t *stats);
+
 /**
  * Check whether the device is currently connected as a station.
  */
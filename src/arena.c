@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Single-block arena for portal memory (CONFIG_WIFI_PROV_STATIC_ALLOC).
+ *
+ * The arena is one heap block taken when the portal starts and returned
+ * in one piece when it stops, so the portal cannot fragment the heap.
+ * Allocation is a bump pointer; freeing the most recent block pops it,
+ * anything else is reclaimed when the whole arena is released.
+ *
+ * The HTTP server task, the scan handler and the application all
+ * allocate from it, so the bump pointer moves under a spinlock. Falling
+ * back to the heap and logging happen outside the critical section.
+ *
+ * A handler still running when the portal stops may free its block after
+ * arena_release(). Live blocks are counted, and a release with blocks
+ * outstanding only closes the arena to new allocations; the block goes
+ * back to the heap with the last arena_free().
+ */
+
+#include "wifi_prov_internal.h"
+#include "freertos/FreeRTOS.h"
+
+#include <stdlib.h>
+
+#define ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+/* Stored in front of each block so the newest one can be popped */
+typedef struct {
+    size_t prev;
+    size_t end;
+} block_hdr_t;
+
+static const char *TAG = "wifi_prov_arena";
+
+static uint8_t *s_base = NULL;
+static size_t   s_size;
+static size_t   s_used;
+static size_t   s_peak;
+static size_t   s_live;     /* blocks handed out and not yet freed */
+static bool     s_open;     /* false while draining after a release */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool in_arena(const void *ptr)
+{
+    return s_base && (const uint8_t *)ptr >= s_base &&
+           (const uint8_t *)ptr < s_base + s_size;
+}
+
+/* Detach the block for freeing; call with s_lock held */
+static uint8_t *take_block(void)
+{
+    uint8_t *base = s_base;
+    s_base = NULL;
+    s_size = 0;
+    s_used = 0;
+    return base;
+}
+
+esp_err_t arena_init(size_t size)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool reopened = s_base != NULL;
+    s_open = true;              /* a draining arena is simply reused */
+    portEXIT_CRITICAL(&s_lock);
+    if (reopened) {
+        return ESP_OK;
+    }
+
+    uint8_t *base = malloc(size);
+    if (!base) {
+        ESP_LOGE(TAG, "Failed to reserve %u byte arena", (unsigned)size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_base = base;
+    s_size = size;
+    s_used = 0;
+    s_peak = 0;
+    s_live = 0;
+    s_open = true;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+void *arena_alloc(size_t size)
+{
+    void *ptr = NULL;
+    bool  exhausted = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_base && s_open) {
+        size_t start = s_used;
+        size_t end   = start + ALIGN(sizeof(block_hdr_t)) + ALIGN(size);
+        if (end <= s_size) {
+            block_hdr_t *hdr = (block_hdr_t *)(s_base + start);
+            hdr->prev = start;
+            hdr->end  = end;
+
+            s_used = end;
+            s_live++;
+            if (s_used > s_peak) {
+                s_peak = s_used;
+            }
+            ptr = s_base + start + ALIGN(sizeof(block_hdr_t));
+        } else {
+            exhausted = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ptr) {
+        return ptr;
+    }
+    if (exhausted) {
+        ESP_LOGW(TAG, "Arena exhausted (%u bytes requested), using heap",
+                 (unsigned)size);
+    }
+    return malloc(size);
+}
+
+void arena_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    uint8_t *drained = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    bool pooled = in_arena(ptr);
+    if (pooled) {
+        block_hdr_t *hdr = (block_hdr_t *)((uint8_t *)ptr - ALIGN(sizeof(block_hdr_t)));
+        if (hdr->end == s_used) {
+            s_used = hdr->prev;
+        }
+        if (--s_live == 0 && !s_open) {
+            drained = take_block();
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!pooled) {
+        free(ptr);
+    }
+    free(drained);
+}
+
+void arena_release(void)
+{
+    if (!s_base) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Arena peak usage: %u of %u bytes",
+             (unsigned)s_peak, (unsigned)s_size);
+
+    portENTER_CRITICAL(&s_lock);
+    s_open = false;
+    size_t   live = s_live;
+    uint8_t *base = live == 0 ? take_block() : NULL;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (live) {
+        ESP_LOGW(TAG, "%u arena blocks still in use, released once freed",
+                 (unsigned)live);
+    }
+    free(base);
+}
@@ -0,0 +1,320 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * BLE provisioning transport: a NimBLE GATT service that receives
+ * credentials and feeds them through the same pipeline as the portal.
+ *
+ * Service 5a1e0001-…: write SSID (…02) and password (…03, encrypted
+ * link), write 0x01 to apply (…04), read/notify status (…05).
+ * Optionally pin the AP first (…06): BSSID (6) + channel (1), with an
+ * all-zero BSSID or channel 0 leaving that part unpinned.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+
+#define UUID_BASE(id) BLE_UUID128_INIT(0x9e, 0x4b, 0x2d, 0x61, 0x87, 0x3c, 0x5f, 0xa0, \
+                                       0x41, 0x4e, 0xd2, 0x7b, id, 0x00, 0x1e, 0x5a)
+
+enum {
+    CHR_SSID,
+    CHR_PASSWORD,
+    CHR_APPLY,
+    CHR_STATUS,
+    CHR_PIN,
+};
+
+enum {
+    STATUS_IDLE,
+    STATUS_CONNECTING,
+    STATUS_CONNECTED,
+    STATUS_FAILED,
+};
+
+static const char *TAG = "wifi_prov_ble";
+
+static const ble_uuid128_t s_svc_uuid      = UUID_BASE(0x01);
+static const ble_uuid128_t s_ssid_uuid     = UUID_BASE(0x02);
+static const ble_uuid128_t s_password_uuid = UUID_BASE(0x03);
+static const ble_uuid128_t s_apply_uuid    = UUID_BASE(0x04);
+static const ble_uuid128_t s_status_uuid   = UUID_BASE(0x05);
+static const ble_uuid128_t s_pin_uuid      = UUID_BASE(0x06);
+
+static wifi_prov_creds_t s_creds;
+static uint8_t           s_status = STATUS_IDLE;
+static uint16_t          s_status_handle;
+static uint8_t           s_own_addr_type;
+static volatile bool     s_busy = false;
+
+static void advertise(void);
+
+/* ── Credential pipeline ────────────────────────────────────────────── */
+
+static void set_status(uint8_t status)
+{
+    s_status = status;
+    ble_gatts_chr_updated(s_status_handle);
+}
+
+/* Runs outside the NimBLE host task: the trial connect blocks */
+static void apply_task(void *arg)
+{
+    wifi_prov_creds_t creds = s_creds;
+
+    set_status(STATUS_CONNECTING);
+    esp_err_t err = provision_apply(&creds);
+    set_status(err == ESP_OK ? STATUS_CONNECTED : STATUS_FAILED);
+
+    if (err == ESP_OK) {
+        /* Give the client a moment to see the result before BLE goes down */
+        vTaskDelay(pdMS_TO_TICKS(500));
+        provision_complete(&creds);
+    }
+
+    memset(&creds, 0, sizeof(creds));
+    s_busy = false;
+    vTaskDelete(NULL);
+}
+
+/* ── GATT ───────────────────────────────────────────────────────────── */
+
+static int write_str(struct ble_gatt_access_ctxt *ctxt, char *dst, size_t dst_len)
+{
+    uint16_t len = 0;
+    if (OS_MBUF_PKTLEN(ctxt->om) > dst_len - 1) {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (ble_hs_mbuf_to_flat(ctxt->om, dst, dst_len - 1, &len) != 0) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    dst[len] = '\0';
+    return 0;
+}
+
+static int chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                      struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    int chr = (int)(intptr_t)arg;
+
+    /* The credentials being tried stay as they were until the result is in */
+    if (s_busy && (chr == CHR_SSID || chr == CHR_PASSWORD || chr == CHR_PIN)) {
+        return BLE_ATT_ERR_WRITE_NOT_PERMITTED;
+    }
+
+    switch (chr) {
+    case CHR_SSID:
+        return write_str(ctxt, s_creds.ssid, sizeof(s_creds.ssid));
+
+    case CHR_PASSWORD:
+        return write_str(ctxt, s_creds.password, sizeof(s_creds.password));
+
+    case CHR_APPLY: {
+        uint8_t cmd = 0;
+        uint16_t len = 0;
+        ble_hs_mbuf_to_flat(ctxt->om, &cmd, sizeof(cmd), &len);
+        if (len != 1 || cmd != 0x01) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        if (s_busy) {
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+        s_busy = true;
+        if (xTaskCreate(apply_task, "wifi_prov_ble", 4096, NULL, 5, NULL) != pdPASS) {
+            s_busy = false;
+            return BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        return 0;
+    }
+
+    case CHR_STATUS:
+        return os_mbuf_append(ctxt->om, &s_status, sizeof(s_status)) == 0
+                   ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+
+    case CHR_PIN: {
+        static const uint8_t none[6] = {0};
+        uint8_t pin[7];
+        uint16_t len = 0;
+        if (OS_MBUF_PKTLEN(ctxt->om) != sizeof(pin) ||
+            ble_hs_mbuf_to_flat(ctxt->om, pin, sizeof(pin), &len) != 0 || pin[6] > 14) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        memcpy(s_creds.bssid, pin, sizeof(s_creds.bssid));
+        s_creds.bssid_set = memcmp(pin, none, sizeof(none)) != 0;
+        s_creds.channel   = pin[6];
+        return 0;
+    }
+    }
+    return BLE_ATT_ERR_UNLIKELY;
+}
+
+static const struct ble_gatt_svc_def s_services[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &s_svc_uuid.u,
+        .characteristics = (struct ble_gatt_chr_def[]) {
+            {
+                .uuid      = &s_ssid_uuid.u,
+                .access_cb = chr_access,
+                .arg       = (void *)CHR_SSID,
+                .flags     = BLE_GATT_CHR_F_WRITE,
+            },
+            {
+                .uuid      = &s_password_uuid.u,
+                .access_cb = chr_access,
+                .arg       = (void *)CHR_PASSWORD,
+                .flags     = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_ENC,
+            },
+            {
+                .uuid      = &s_apply_uuid.u,
+                .access_cb = chr_access,
+                .arg       = (void *)CHR_APPLY,
+                .flags     = BLE_GATT_CHR_F_WRITE,
+            },
+            {
+                .uuid       = &s_status_uuid.u,
+                .access_cb  = chr_access,
+                .arg        = (void *)CHR_STATUS,
+                .flags      = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                .val_handle = &s_status_handle,
+            },
+            {
+                .uuid      = &s_pin_uuid.u,
+                .access_cb = chr_access,
+                .arg       = (void *)CHR_PIN,
+                .flags     = BLE_GATT_CHR_F_WRITE,
+            },
+            { 0 },
+        },
+    },
+    { 0 },
+};
+
+/* ── GAP ────────────────────────────────────────────────────────────── */
+
+static int gap_event(struct ble_gap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT:
+        if (event->connect.status != 0) {
+            advertise();
+        }
+        break;
+    case BLE_GAP_EVENT_DISCONNECT:
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        advertise();
+        break;
+    case BLE_GAP_EVENT_REPEAT_PAIRING: {
+        /* No bonds are kept, so just forget the old pairing */
+        struct ble_gap_conn_desc desc;
+        if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0) {
+            ble_store_util_delete_peer(&desc.peer_id_addr);
+        }
+        return BLE_GAP_REPEAT_PAIRING_RETRY;
+    }
+    default:
+        break;
+    }
+    return 0;
+}
+
+static void advertise(void)
+{
+    struct ble_hs_adv_fields fields = {
+        .flags                = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
+        .uuids128             = &s_svc_uuid,
+        .num_uuids128         = 1,
+        .uuids128_is_complete = 1,
+    };
+    ble_gap_adv_set_fields(&fields);
+
+    struct ble_gap_adv_params params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+    };
+    int rc = ble_gap_adv_start(s_own_addr_type, NULL, BLE_HS_FOREVER,
+                               &params, gap_event, NULL);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "Failed to start advertising (%d)", rc);
+    }
+}
+
+static void on_sync(void)
+{
+    ble_hs_util_ensure_addr(0);
+    ble_hs_id_infer_auto(0, &s_own_addr_type);
+    advertise();
+}
+
+static void host_task(void *arg)
+{
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+/* ── Transport ──────────────────────────────────────────────────────── */
+
+static esp_err_t ble_transport_start(const wifi_prov_config_t *config)
+{
+    /* The STA side must run for the scan and the trial connect */
+    wifi_sta_netif();
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    /* Populate the scan cache so the chosen network's auth mode is known */
+    wifi_scan_run(0);
+
+    memset(&s_creds, 0, sizeof(s_creds));
+    s_status = STATUS_IDLE;
+
+    esp_err_t err = nimble_port_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init NimBLE (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    /* Just Works pairing: encrypts the link for the password write */
+    ble_hs_cfg.sync_cb         = on_sync;
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+    ble_hs_cfg.sm_io_cap       = BLE_HS_IO_NO_INPUT_OUTPUT;
+    ble_hs_cfg.sm_bonding      = 0;
+    ble_hs_cfg.sm_sc           = 1;
+
+    ble_svc_gap_init();
+    ble_svc_gatt_init();
+    if (ble_gatts_count_cfg(s_services) != 0 ||
+        ble_gatts_add_svcs(s_services) != 0) {
+        nimble_port_deinit();
+        return ESP_FAIL;
+    }
+    ble_svc_gap_device_name_set(config->ap_ssid);
+
+    nimble_port_freertos_init(host_task);
+
+    ESP_LOGI(TAG, "BLE provisioning started – name: \"%s\"", config->ap_ssid);
+    return ESP_OK;
+}
+
+static esp_err_t ble_transport_stop(void)
+{
+    if (nimble_port_stop() == 0) {
+        nimble_port_deinit();
+    }
+    memset(&s_creds, 0, sizeof(s_creds));
+    ESP_LOGI(TAG, "BLE provisioning stopped");
+    return ESP_OK;
+}
+
+const prov_transport_t prov_transport_ble = {
+    .name  = "BLE provisioning",
+    .start = ble_transport_start,
+    .stop  = ble_transport_stop,
+};
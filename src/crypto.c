@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * AES-256-GCM sealing of small blobs (stored credentials) and
+ * WPA2 PMK derivation.
+ *
+ * Blob layout: version (1) | nonce (12) | ciphertext | tag (16)
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_random.h"
+#include "mbedtls/version.h"
+#include "mbedtls/pkcs5.h"
+#if CONFIG_SOC_HMAC_SUPPORTED
+#include "esp_hmac.h"
+#endif
+
+#define BLOB_VERSION 1
+#define NONCE_LEN    12
+#define TAG_LEN      16
+
+static const char *TAG = "wifi_prov_crypto";
+
+esp_err_t crypto_key_init(crypto_key_t *key, const uint8_t material[CRYPTO_KEY_LEN])
+{
+    mbedtls_gcm_init(&key->gcm);
+    if (mbedtls_gcm_setkey(&key->gcm, MBEDTLS_CIPHER_ID_AES,
+                           material, CRYPTO_KEY_LEN * 8) != 0) {
+        mbedtls_gcm_free(&key->gcm);
+        return ESP_FAIL;
+    }
+    key->ready = true;
+    return ESP_OK;
+}
+
+void crypto_key_free(crypto_key_t *key)
+{
+    if (key->ready) {
+        mbedtls_gcm_free(&key->gcm);
+        key->ready = false;
+    }
+}
+
+esp_err_t crypto_seal(crypto_key_t *key, const void *plain, size_t len,
+                      const void *aad, size_t aad_len,
+                      uint8_t *out, size_t *out_len)
+{
+    if (!key->ready || *out_len < len + CRYPTO_OVERHEAD) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t *nonce = out + 1;
+    uint8_t *ct    = nonce + NONCE_LEN;
+    uint8_t *tag   = ct + len;
+
+    out[0] = BLOB_VERSION;
+    esp_fill_random(nonce, NONCE_LEN);
+
+    if (mbedtls_gcm_crypt_and_tag(&key->gcm, MBEDTLS_GCM_ENCRYPT, len,
+                                  nonce, NONCE_LEN, aad, aad_len,
+                                  plain, ct, TAG_LEN, tag) != 0) {
+        return ESP_FAIL;
+    }
+
+    *out_len = len + CRYPTO_OVERHEAD;
+    return ESP_OK;
+}
+
+esp_err_t crypto_open(crypto_key_t *key, const uint8_t *blob, size_t blob_len,
+                      const void *aad, size_t aad_len,
+                      void *plain, size_t *len)
+{
+    if (!key->ready || blob_len < CRYPTO_OVERHEAD) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (blob[0] != BLOB_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    size_t ct_len = blob_len - CRYPTO_OVERHEAD;
+    if (*len < ct_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t *nonce = blob + 1;
+    const uint8_t *ct    = nonce + NONCE_LEN;
+    const uint8_t *tag   = ct + ct_len;
+
+    if (mbedtls_gcm_auth_decrypt(&key->gcm, ct_len, nonce, NONCE_LEN,
+                                 aad, aad_len, tag, TAG_LEN, ct, plain) != 0) {
+        ESP_LOGW(TAG, "Authentication failed");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *len = ct_len;
+    return ESP_OK;
+}
+
+esp_err_t crypto_efuse_key(uint8_t material[CRYPTO_KEY_LEN])
+{
+#if CONFIG_SOC_HMAC_SUPPORTED && CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    static const char label[] = "wifi_prov credentials";
+    return esp_hmac_calculate(HMAC_KEY0 + CONFIG_WIFI_PROV_HMAC_KEY_ID,
+                              label, sizeof(label) - 1, material);
+#else
+    ESP_LOGE(TAG, "No HMAC peripheral, register a key provider");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t crypto_wpa_pmk(const char *ssid, const char *passphrase,
+                         uint8_t pmk[WIFI_PMK_LEN])
+{
+    /* IEEE 802.11i: PMK = PBKDF2-HMAC-SHA1(passphrase, ssid, 4096, 256 bits) */
+#if MBEDTLS_VERSION_NUMBER >= 0x03030000
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                  (const unsigned char *)passphrase, strlen(passphrase),
+                  (const unsigned char *)ssid, strlen(ssid),
+                  4096, WIFI_PMK_LEN, pmk);
+#else
+    mbedtls_md_context_t md;
+    mbedtls_md_init(&md);
+    int ret = mbedtls_md_setup(&md, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1);
+    if (ret == 0) {
+        ret = mbedtls_pkcs5_pbkdf2_hmac(&md,
+                  (const unsigned char *)passphrase, strlen(passphrase),
+                  (const unsigned char *)ssid, strlen(ssid),
+                  4096, WIFI_PMK_LEN, pmk);
+    }
+    mbedtls_md_free(&md);
+#endif
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
@@ -11,18 +11,40 @@
 #include "lwip/netdb.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #define DNS_PORT       53
 #define DNS_BUF_SIZE   512
+#define DNS_STACK_SIZE 4096
 
 static const char *TAG = "wifi_prov_dns";
 
 static TaskHandle_t s_task = NULL;
 static int          s_sock = -1;
+static SemaphoreHandle_t s_exited = NULL;
+static StaticSemaphore_t s_exited_buf;
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+static StackType_t  *s_stack = NULL;
+static StaticTask_t *s_tcb   = NULL;
+#endif
 
 /*
- * Minimal DNS response: copy the query and flip header bits to make it
- * a valid reply that points every name at the AP gateway (192.168.4.1).
+ * The task never deletes itself: it signals and parks here, and
+ * dns_server_stop() waits for the signal before deleting it, so its
+ * stack is known to be unused once stop returns.
+ */
+static void dns_task_exit(void)
+{
+    ESP_LOGI(TAG, "DNS server stopped");
+    xSemaphoreGive(s_exited);
+    for (;;) {
+        vTaskSuspend(NULL);
+    }
+}
+
+/*
+ * Minimal DNS server: every query is answered in place with the AP
+ * gateway (192.168.4.1), see dns_build_response().
  */
 static void dns_task(void *arg)
 {
@@ -33,11 +55,41 @@ static void dns_task(void *arg)
     /* AP gateway address – default for esp_netif soft-AP */
     const uint32_t ap_ip = htonl(0xC0A80401); /* 192.168.4.1 */
 
+    while (1) {
+        client_len = sizeof(client);
+        int len = recvfrom(s_sock, buf, sizeof(buf), 0,
+                           (struct sockaddr *)&client, &client_len);
+        if (len < 0) {
+            break; /* socket closed by dns_server_stop() */
+        }
+        size_t reply_len = dns_build_response(buf, (size_t)len, sizeof(buf), ap_ip);
+        if (reply_len == 0) {
+            continue; /* not a query we can answer in one datagram */
+        }
+
+        sendto(s_sock, buf, reply_len, 0,
+               (struct sockaddr *)&client, client_len);
+        stats_record(STATS_DNS_QUERY, (uint16_t)reply_len, 0);
+    }
+
+    dns_task_exit();
+}
+
+esp_err_t dns_server_start(void)
+{
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+    /*
+     * The socket is set up here rather than in the task, so a stop right
+     * after start always finds it to close and the task never blocks on
+     * a socket nobody knows about.
+     */
     s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (s_sock < 0) {
         ESP_LOGE(TAG, "Failed to create socket");
-        vTaskDelete(NULL);
-        return;
+        return ESP_FAIL;
     }
 
     struct sockaddr_in addr = {
@@ -50,69 +102,28 @@ static void dns_task(void *arg)
         ESP_LOGE(TAG, "Failed to bind DNS socket");
         close(s_sock);
         s_sock = -1;
-        vTaskDelete(NULL);
-        return;
+        return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "DNS server listening on port %d", DNS_PORT);
-
-    while (1) {
-        client_len = sizeof(client);
-        int len = recvfrom(s_sock, buf, sizeof(buf), 0,
-                           (struct sockaddr *)&client, &client_len);
-        if (len < 0) {
-            break; /* socket closed by dns_server_stop() */
-        }
-        if (len < 12) {
-            continue; /* too short for a DNS header */
-        }
+    s_exited = xSemaphoreCreateBinaryStatic(&s_exited_buf);
 
-        /* Build response in-place */
-        buf[2] = 0x81; /* QR=1, Opcode=0, AA=1 */
-        buf[3] = 0x80; /* RA=1, RCODE=0 (No error) */
-        /* Answer count = 1 */
-        buf[6] = 0x00;
-        buf[7] = 0x01;
-
-        /* Append answer section right after the query */
-        uint8_t *p = buf + len;
-
-        /* Name pointer to the question name (offset 12) */
-        *p++ = 0xC0;
-        *p++ = 0x0C;
-        /* Type A */
-        *p++ = 0x00;
-        *p++ = 0x01;
-        /* Class IN */
-        *p++ = 0x00;
-        *p++ = 0x01;
-        /* TTL = 60 seconds */
-        *p++ = 0x00;
-        *p++ = 0x00;
-        *p++ = 0x00;
-        *p++ = 0x3C;
-        /* Data length = 4 */
-        *p++ = 0x00;
-        *p++ = 0x04;
-        /* IP address */
-        memcpy(p, &ap_ip, 4);
-        p += 4;
-
-        sendto(s_sock, buf, (size_t)(p - buf), 0,
-               (struct sockaddr *)&client, client_len);
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    s_stack = prov_malloc(DNS_STACK_SIZE);
+    s_tcb   = prov_malloc(sizeof(StaticTask_t));
+    if (s_stack && s_tcb) {
+        s_task = xTaskCreateStatic(dns_task, "dns_server", DNS_STACK_SIZE,
+                                   NULL, 5, s_stack, s_tcb);
     }
-
-    ESP_LOGI(TAG, "DNS server stopped");
-    vTaskDelete(NULL);
-}
-
-esp_err_t dns_server_start(void)
-{
-    if (s_task != NULL) {
-        return ESP_ERR_INVALID_STATE;
+#else
+    xTaskCreate(dns_task, "dns_server", DNS_STACK_SIZE, NULL, 5, &s_task);
+#endif
+    if (s_task == NULL) {
+        ESP_LOGE(TAG, "Failed to create DNS task");
+        dns_server_stop();
+        return ESP_ERR_NO_MEM;
     }
 
-    xTaskCreate(dns_task, "dns_server", 4096, NULL, 5, &s_task);
+    ESP_LOGI(TAG, "DNS server listening on port %d", DNS_PORT);
     return ESP_OK;
 }
 
@@ -123,6 +134,23 @@ esp_err_t dns_server_stop(void)
         close(s_sock);
         s_sock = -1;
     }
-    s_task = NULL;
+
+    if (s_task) {
+        /* Wait for the task to leave recvfrom() and park itself */
+        xSemaphoreTake(s_exited, portMAX_DELAY);
+        vTaskDelete(s_task);
+        s_task = NULL;
+    }
+    if (s_exited) {
+        vSemaphoreDelete(s_exited);
+        s_exited = NULL;
+    }
+
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    prov_free(s_tcb);
+    prov_free(s_stack);
+    s_tcb   = NULL;
+    s_stack = NULL;
+#endif
     return ESP_OK;
 }
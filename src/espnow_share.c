@@ -0,0 +1,243 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * ESP-NOW credential sharing for bulk installs: a provisioned device
+ * broadcasts its credential record, unprovisioned peers pick it up
+ * before falling back to their own portal.
+ *
+ * Frame layout: magic (4) | AES-GCM blob of share_record_t
+ * The key is SHA-256 of CONFIG_WIFI_PROV_ESPNOW_KEY; the magic is
+ * authenticated as associated data.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "mbedtls/sha256.h"
+
+#define SHARE_MAGIC        "WPV1"
+#define SHARE_MAGIC_LEN    4
+#define SEND_INTERVAL_MS   100
+#define SEND_JITTER_MS     50   /* spreads senders so they do not collide */
+#define DWELL_MS           (3 * (SEND_INTERVAL_MS + SEND_JITTER_MS))
+#define CHANNEL_MAX        13
+#define SHARE_KEY_MIN_LEN  16
+
+/* The key is only as secret as the PSK: SHA-256("") is no key at all */
+_Static_assert(sizeof(CONFIG_WIFI_PROV_ESPNOW_KEY) - 1 >= SHARE_KEY_MIN_LEN,
+               "CONFIG_WIFI_PROV_ESPNOW_KEY must be at least 16 characters");
+
+typedef struct __attribute__((packed)) {
+    char    ssid[33];
+    char    password[65];
+    uint8_t authmode;
+} share_record_t;
+
+#define FRAME_LEN (SHARE_MAGIC_LEN + CRYPTO_OVERHEAD + sizeof(share_record_t))
+
+typedef struct {
+    uint8_t data[FRAME_LEN];
+} share_frame_t;
+
+static const char *TAG = "wifi_prov_espnow";
+
+static const uint8_t s_broadcast[ESP_NOW_ETH_ALEN] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+static QueueHandle_t s_rx_queue = NULL;
+
+static esp_err_t share_key_init(crypto_key_t *key)
+{
+    uint8_t material[CRYPTO_KEY_LEN];
+    const char *psk = CONFIG_WIFI_PROV_ESPNOW_KEY;
+
+    if (mbedtls_sha256((const unsigned char *)psk, strlen(psk), material, 0) != 0) {
+        return ESP_FAIL;
+    }
+    esp_err_t err = crypto_key_init(key, material);
+    memset(material, 0, sizeof(material));
+    return err;
+}
+
+/* ── Sender ─────────────────────────────────────────────────────────── */
+
+esp_err_t espnow_share_send(uint32_t duration_ms)
+{
+    wifi_prov_creds_t creds = {0};
+    esp_err_t err = nvs_store_load(&creds);
+    if (err != ESP_OK || creds.ssid[0] == '\0') {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    share_record_t record = { .authmode = (uint8_t)creds.authmode };
+    memcpy(record.ssid, creds.ssid, sizeof(record.ssid));
+    memcpy(record.password, creds.password, sizeof(record.password));
+    memset(&creds, 0, sizeof(creds));
+
+    crypto_key_t key = {0};
+    share_frame_t frame;
+    size_t blob_len = sizeof(frame.data) - SHARE_MAGIC_LEN;
+
+    memcpy(frame.data, SHARE_MAGIC, SHARE_MAGIC_LEN);
+    err = share_key_init(&key);
+    if (err == ESP_OK) {
+        err = crypto_seal(&key, &record, sizeof(record), SHARE_MAGIC, SHARE_MAGIC_LEN,
+                          frame.data + SHARE_MAGIC_LEN, &blob_len);
+    }
+    crypto_key_free(&key);
+    memset(&record, 0, sizeof(record));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* The application may run ESP-NOW itself; then it stays up afterwards */
+    esp_now_peer_num_t peers;
+    bool owned = esp_now_get_peer_num(&peers) == ESP_ERR_ESPNOW_NOT_INIT;
+    if (owned) {
+        err = esp_now_init();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to init ESP-NOW (%s)", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    /* Channel 0: transmit on whatever channel the STA link uses */
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx   = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, s_broadcast, ESP_NOW_ETH_ALEN);
+    err = esp_now_add_peer(&peer);
+    bool added = err == ESP_OK;
+    if (err == ESP_ERR_ESPNOW_EXIST) {
+        err = ESP_OK;           /* the application's broadcast peer */
+    }
+
+    ESP_LOGI(TAG, "Sharing credentials for %u ms …", (unsigned)duration_ms);
+
+    unsigned sent = 0;
+    int64_t end = esp_timer_get_time() + (int64_t)duration_ms * 1000;
+    while (err == ESP_OK && esp_timer_get_time() < end) {
+        if (esp_now_send(s_broadcast, frame.data, sizeof(frame.data)) == ESP_OK) {
+            sent++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(SEND_INTERVAL_MS + esp_random() % SEND_JITTER_MS));
+    }
+
+    if (owned) {
+        esp_now_deinit();
+    } else if (added) {
+        esp_now_del_peer(s_broadcast);
+    }
+    memset(&frame, 0, sizeof(frame));
+
+    ESP_LOGI(TAG, "Credential sharing done, %u frames sent", sent);
+    return err;
+}
+
+/* ── Receiver ───────────────────────────────────────────────────────── */
+
+static void on_recv(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    /* Runs in the WiFi task: only filter and hand off */
+    if (len != (int)FRAME_LEN || memcmp(data, SHARE_MAGIC, SHARE_MAGIC_LEN) != 0) {
+        return;
+    }
+    share_frame_t frame;
+    memcpy(frame.data, data, FRAME_LEN);
+    xQueueSend(s_rx_queue, &frame, 0);
+}
+
+static bool open_frame(crypto_key_t *key, const share_frame_t *frame,
+                       wifi_prov_creds_t *creds)
+{
+    share_record_t record;
+    size_t len = sizeof(record);
+
+    if (crypto_open(key, frame->data + SHARE_MAGIC_LEN, FRAME_LEN - SHARE_MAGIC_LEN,
+                    SHARE_MAGIC, SHARE_MAGIC_LEN, &record, &len) != ESP_OK ||
+        len != sizeof(record)) {
+        return false;
+    }
+
+    record.ssid[sizeof(record.ssid) - 1]         = '\0';
+    record.password[sizeof(record.password) - 1] = '\0';
+
+    memcpy(creds->ssid, record.ssid, sizeof(creds->ssid));
+    memcpy(creds->password, record.password, sizeof(creds->password));
+    creds->authmode = (wifi_auth_mode_t)record.authmode;
+    memset(&record, 0, sizeof(record));
+    return creds->ssid[0] != '\0';
+}
+
+/*
+ * Listen for a shared credential record, starting on first_channel and
+ * then sweeping the remaining channels. Expects an initialised (not
+ * started) WiFi driver and leaves it stopped.
+ */
+esp_err_t espnow_share_receive(uint8_t first_channel, uint32_t listen_ms,
+                               wifi_prov_creds_t *creds)
+{
+    crypto_key_t key = {0};
+    esp_err_t err = share_key_init(&key);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_rx_queue = xQueueCreate(2, sizeof(share_frame_t));
+    if (!s_rx_queue) {
+        crypto_key_free(&key);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    err = esp_now_init();
+    if (err == ESP_OK) {
+        esp_now_register_recv_cb(on_recv);
+    }
+
+    ESP_LOGI(TAG, "Listening for shared credentials …");
+
+    err = (err == ESP_OK) ? ESP_ERR_NOT_FOUND : err;
+    int64_t end = esp_timer_get_time() + (int64_t)listen_ms * 1000;
+    uint8_t channel = first_channel ? first_channel : 1;
+
+    while (err == ESP_ERR_NOT_FOUND && esp_timer_get_time() < end) {
+        esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+
+        share_frame_t frame;
+        int64_t dwell_end = esp_timer_get_time() + DWELL_MS * 1000;
+        while (esp_timer_get_time() < dwell_end) {
+            if (xQueueReceive(s_rx_queue, &frame, pdMS_TO_TICKS(DWELL_MS)) != pdTRUE) {
+                break;
+            }
+            if (open_frame(&key, &frame, creds)) {
+                ESP_LOGI(TAG, "Received credentials for \"%s\" on channel %d",
+                         creds->ssid, channel);
+                err = ESP_OK;
+                break;
+            }
+        }
+
+        channel = channel % CHANNEL_MAX + 1;
+    }
+
+    esp_now_unregister_recv_cb();
+    esp_now_deinit();
+    esp_wifi_stop();
+
+    vQueueDelete(s_rx_queue);
+    s_rx_queue = NULL;
+    crypto_key_free(&key);
+    return err;
+}
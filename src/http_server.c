@@ -8,175 +8,179 @@
 #include "wifi_prov_internal.h"
 #include "esp_wifi.h"
 #include "esp_http_server.h"
-#include "esp_event.h"
+#include "esp_timer.h"
+#if CONFIG_WIFI_PROV_HTTPS
+#include "esp_https_server.h"
+#endif
 
-#include <stdlib.h>
+#include <ctype.h>
+#include <strings.h>
 
-static const char *TAG = "wifi_prov_http";
-
-static httpd_handle_t s_server = NULL;
-static const wifi_prov_config_t *s_page_config = NULL;
+#if CONFIG_WIFI_PROV_HTTPS
+#define STR_(x)    #x
+#define STR(x)     STR_(x)
+#define PORTAL_URL "https://192.168.4.1:" STR(CONFIG_WIFI_PROV_HTTPS_PORT) "/"
+#else
+#define PORTAL_URL "http://192.168.4.1/"
+#endif
 
-/* ── Event posted when the user submits credentials ─────────────────── */
+/* Page reloads and several clients within this window share one scan */
+#define SCAN_REUSE_MS 3000
 
-ESP_EVENT_DECLARE_BASE(WIFI_PROV_EVENT);
-ESP_EVENT_DEFINE_BASE(WIFI_PROV_EVENT);
+static const char *TAG = "wifi_prov_http";
 
-enum {
-    WIFI_PROV_EVENT_CREDENTIALS_SET,
-};
+static httpd_handle_t s_server = NULL;
+#if CONFIG_WIFI_PROV_HTTPS
+static httpd_handle_t s_redirect_server = NULL;
+static tls_cert_t     s_cert;
+#endif
 
+/* Rendered /config document, swapped whole when the branding changes */
 typedef struct {
-    char ssid[33];
-    char password[65];
-} wifi_prov_creds_t;
-
-/* ── Embedded HTML (see src/portal.html) ─────────────────────────────── */
+    size_t len;
+    char   etag[11];    /* "%08x" with quotes */
+    char   json[];
+} config_doc_t;
 
-extern const uint8_t portal_html_start[]    asm("_binary_portal_html_start");
-extern const uint8_t portal_html_end[]      asm("_binary_portal_html_end");
+static config_doc_t *s_config_doc = NULL;
 
-/* ── URL decoding ───────────────────────────────────────────────────── */
+/* ── Localised pages (see src/html, tools/gen_portal.py) ────────────── */
 
-static int hex_val(char c)
+/*
+ * First language in Accept-Language ("de-CH,de;q=0.9,en;q=0.8") that
+ * has a page. Clients list tags in preference order, so q-values are
+ * not needed to rank them.
+ */
+static const portal_asset_t *portal_for(httpd_req_t *req)
 {
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
-    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-    return -1;
+    char langs[64];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Language",
+                                                langs, sizeof(langs));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return &portal_assets[0];
+    }
+
+    for (const char *p = langs; p; p = strchr(p, ',')) {
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+        int a = tolower((unsigned char)p[0]) - 'a';
+        int b = p[0] ? tolower((unsigned char)p[1]) - 'a' : -1;
+        if (a < 0 || a >= 26 || b < 0 || b >= 26 || isalpha((unsigned char)p[2])) {
+            continue;
+        }
+        uint8_t idx = portal_locale_index[a * 26 + b];
+        if (idx) {
+            return &portal_assets[idx - 1];
+        }
+    }
+    return &portal_assets[0];
 }
 
-static void url_decode(char *dst, size_t dst_len, const char *src, size_t src_len)
+/*
+ * Whether Accept-Encoding admits gzip: gzip (or x-gzip) listed with a
+ * non-zero q, or failing that a non-zero "*". A missing header is taken
+ * as identity only, which is what clients that omit it can read.
+ */
+static bool accepts_gzip(httpd_req_t *req)
 {
-    size_t di = 0;
-    for (size_t si = 0; si < src_len && di < dst_len - 1; si++) {
-        if (src[si] == '+') {
-            dst[di++] = ' ';
-        } else if (src[si] == '%' && si + 2 < src_len) {
-            int hi = hex_val(src[si + 1]);
-            int lo = hex_val(src[si + 2]);
-            if (hi >= 0 && lo >= 0) {
-                dst[di++] = (char)((hi << 4) | lo);
-                si += 2;
-            } else {
-                dst[di++] = src[si];
-            }
-        } else {
-            dst[di++] = src[si];
+    char codings[96];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding",
+                                                codings, sizeof(codings));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+
+    int   wildcard = -1; /* not listed */
+    char *save;
+    for (char *p = strtok_r(codings, ",", &save); p; p = strtok_r(NULL, ",", &save)) {
+        p += strspn(p, " ");
+        size_t len = strcspn(p, " ;");
+        const char *q = strstr(p, ";q=");
+        bool accepted = !q || strtof(q + 3, NULL) > 0;
+
+        if ((len == 4 && strncasecmp(p, "gzip", 4) == 0) ||
+            (len == 6 && strncasecmp(p, "x-gzip", 6) == 0)) {
+            return accepted;
+        }
+        if (len == 1 && *p == '*') {
+            wildcard = accepted;
         }
     }
-    dst[di] = '\0';
+    return wildcard == 1;
 }
 
 /* ── Handlers ───────────────────────────────────────────────────────── */
 
 static esp_err_t config_handler(httpd_req_t *req)
 {
-    char json[512];
-    snprintf(json, sizeof(json),
-             "{\"title\":\"%s\","
-             "\"portal_header\":\"%s\","
-             "\"portal_subheader\":\"%s\","
-             "\"connected_header\":\"%s\","
-             "\"connected_subheader\":\"%s\","
-             "\"footer\":\"%s\"}",
-             s_page_config->page_title,
-             s_page_config->portal_header,
-             s_page_config->portal_subheader,
-             s_page_config->connected_header,
-             s_page_config->connected_subheader,
-             s_page_config->page_footer);
+    const config_doc_t *doc = s_config_doc;
+    char etag[sizeof(doc->etag)];
+
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", doc->etag);
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+        strcmp(etag, doc->etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
     httpd_resp_set_type(req, "application/json");
-    return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+    return httpd_resp_send(req, doc->json, doc->len);
 }
 
 static esp_err_t root_handler(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "text/html");
-    const size_t len = portal_html_end - portal_html_start;
-    return httpd_resp_send(req, (const char *)portal_html_start, len);
+    const portal_asset_t *page = portal_for(req);
+
+    httpd_resp_set_type(req, "text/html; charset=utf-8");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Language, Accept-Encoding");
+    if (!accepts_gzip(req)) {
+        return httpd_resp_send(req, (const char *)page->plain, page->plain_len);
+    }
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)page->gz, page->gz_len);
 }
 
 static esp_err_t scan_handler(httpd_req_t *req)
 {
-    uint16_t ap_count = 0;
-    wifi_ap_record_t *ap_records = NULL;
-
-    wifi_scan_config_t scan_cfg = {
-        .show_hidden = false,
-    };
-    esp_err_t err = esp_wifi_scan_start(&scan_cfg, true);
-    if (err != ESP_OK) {
+    if (wifi_scan_run(SCAN_REUSE_MS) != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Scan failed");
         return ESP_FAIL;
     }
 
-    esp_wifi_scan_get_ap_num(&ap_count);
-    if (ap_count == 0) {
-        httpd_resp_set_type(req, "application/json");
-        return httpd_resp_send(req, "[]", 2);
-    }
-
-    ap_records = malloc(sizeof(wifi_ap_record_t) * ap_count);
-    if (!ap_records) {
+    /* A copy, so a scan finishing meanwhile cannot change it under us */
+    wifi_scan_entry_t *nets = prov_malloc(CONFIG_WIFI_PROV_SCAN_CACHE_SIZE * sizeof(*nets));
+    if (!nets) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_ERR_NO_MEM;
     }
-    esp_wifi_scan_get_ap_records(&ap_count, ap_records);
-
-    /* Deduplicate by SSID, keeping the strongest signal */
-    uint16_t unique_count = 0;
-    for (int i = 0; i < ap_count; i++) {
-        if (ap_records[i].ssid[0] == '\0') continue; /* skip hidden */
-        bool dup = false;
-        for (int j = 0; j < i; j++) {
-            if (strcmp((char *)ap_records[i].ssid, (char *)ap_records[j].ssid) == 0) {
-                dup = true;
-                if (ap_records[i].rssi > ap_records[j].rssi) {
-                    ap_records[j].rssi = ap_records[i].rssi;
-                }
-                break;
-            }
-        }
-        if (!dup) {
-            if (unique_count != i) {
-                ap_records[unique_count] = ap_records[i];
-            }
-            unique_count++;
-        }
+    uint16_t count = wifi_scan_cache_snapshot(nets, CONFIG_WIFI_PROV_SCAN_CACHE_SIZE);
+    if (count == 0) {
+        prov_free(nets);
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, "[]", 2);
     }
 
-    /* Build JSON array */
-    char *json = malloc(unique_count * 80 + 4);
+    char *json = prov_malloc(json_networks_max(count));
     if (!json) {
-        free(ap_records);
+        prov_free(nets);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_ERR_NO_MEM;
     }
-
-    char *p = json;
-    *p++ = '[';
-    for (int i = 0; i < unique_count; i++) {
-        if (i > 0) *p++ = ',';
-        p += sprintf(p, "{\"ssid\":\"%s\",\"rssi\":%d,\"auth\":%d}",
-                     (char *)ap_records[i].ssid, ap_records[i].rssi,
-                     ap_records[i].authmode);
-    }
-    *p++ = ']';
-    *p   = '\0';
-
-    free(ap_records);
+    size_t len = json_networks(json, nets, count);
 
     httpd_resp_set_type(req, "application/json");
-    esp_err_t ret = httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
-    free(json);
+    esp_err_t ret = httpd_resp_send(req, json, len);
+    prov_free(json);
+    prov_free(nets);
     return ret;
 }
 
 static esp_err_t save_handler(httpd_req_t *req)
 {
-    char buf[256];
+    char buf[384]; /* fully percent-encoded SSID and password, plus the pin */
     int received = httpd_req_recv(req, buf, sizeof(buf) - 1);
     if (received <= 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No data");
@@ -187,42 +191,40 @@ static esp_err_t save_handler(httpd_req_t *req)
     wifi_prov_creds_t creds = {0};
 
     /* Parse "ssid=...&password=..." */
-    char *ssid_start = strstr(buf, "ssid=");
-    char *pass_start = strstr(buf, "password=");
-
-    if (!ssid_start) {
+    if (!form_field(buf, "ssid", creds.ssid, sizeof(creds.ssid))) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing SSID");
         return ESP_FAIL;
     }
-
-    ssid_start += 5; /* skip "ssid=" */
-    char *ssid_end = strchr(ssid_start, '&');
-    size_t ssid_len = ssid_end ? (size_t)(ssid_end - ssid_start)
-                               : strlen(ssid_start);
-    url_decode(creds.ssid, sizeof(creds.ssid), ssid_start, ssid_len);
-
-    if (pass_start) {
-        pass_start += 9; /* skip "password=" */
-        char *pass_end = strchr(pass_start, '&');
-        size_t pass_len = pass_end ? (size_t)(pass_end - pass_start)
-                                   : strlen(pass_start);
-        url_decode(creds.password, sizeof(creds.password), pass_start, pass_len);
+    form_field(buf, "password", creds.password, sizeof(creds.password));
+
+    /* Optional pin, e.g. for hidden networks: empty fields mean none */
+    char field[18];
+    if (form_field(buf, "bssid", field, sizeof(field)) && field[0] != '\0') {
+        if (!parse_bssid(field, creds.bssid)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid BSSID");
+            return ESP_FAIL;
+        }
+        creds.bssid_set = true;
+    }
+    if (form_field(buf, "channel", field, sizeof(field)) && field[0] != '\0') {
+        int channel = atoi(field);
+        if (channel < 1 || channel > 14) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid channel");
+            return ESP_FAIL;
+        }
+        creds.channel = (uint8_t)channel;
     }
 
     ESP_LOGI(TAG, "Received credentials – SSID: \"%s\"", creds.ssid);
 
     /* Try connecting while keeping the AP alive */
-    esp_err_t err = wifi_sta_try_connect(creds.ssid, creds.password);
+    esp_err_t err = provision_apply(&creds);
 
     httpd_resp_set_type(req, "application/json");
 
     if (err == ESP_OK) {
-        nvs_store_save(creds.ssid, creds.password);
         httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
-
-        /* Post event so the orchestrator can switch to STA-only mode */
-        esp_event_post(WIFI_PROV_EVENT, WIFI_PROV_EVENT_CREDENTIALS_SET,
-                       &creds, sizeof(creds), pdMS_TO_TICKS(100));
+        provision_complete(&creds);
     } else {
         httpd_resp_send(req, "{\"success\":false}", HTTPD_RESP_USE_STRLEN);
     }
@@ -230,74 +232,260 @@ static esp_err_t save_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+#if CONFIG_WIFI_PROV_STATS
+/*
+ * Events logged between sizing and filling lengthen the dump, so leave
+ * room for a few and size again if even that was not enough
+ */
+#define EVENTS_HEADROOM 256
+#define EVENTS_ATTEMPTS 3
+
+static esp_err_t events_handler(httpd_req_t *req)
+{
+    size_t len = stats_dump(NULL, 0) + EVENTS_HEADROOM;
+    for (int attempt = 0; attempt < EVENTS_ATTEMPTS; attempt++) {
+        char *json = prov_malloc(len);
+        if (!json) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+            return ESP_ERR_NO_MEM;
+        }
+        size_t need = stats_dump(json, len);
+        if (need < len) {
+            httpd_resp_set_type(req, "application/json");
+            esp_err_t ret = httpd_resp_send(req, json, need);
+            prov_free(json);
+            return ret;
+        }
+        prov_free(json);
+        len = need + EVENTS_HEADROOM;
+    }
+
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Event log busy");
+    return ESP_FAIL;
+}
+#endif
+
 /* Redirect any unknown path to "/" for captive portal detection */
 static esp_err_t redirect_handler(httpd_req_t *req)
 {
     httpd_resp_set_status(req, "302 Found");
-    httpd_resp_set_hdr(req, "Location", "http://192.168.4.1/");
+    httpd_resp_set_hdr(req, "Location", PORTAL_URL);
     return httpd_resp_send(req, NULL, 0);
 }
 
-/* ── Start / Stop ───────────────────────────────────────────────────── */
+/* ── /config document ───────────────────────────────────────────────── */
 
-esp_err_t http_server_start(uint16_t port, const wifi_prov_config_t *page_config)
+/* Rendered once per branding change, so requests only copy it out */
+static config_doc_t *config_doc_render(const wifi_prov_config_t *cfg)
 {
-    if (s_server) {
-        return ESP_ERR_INVALID_STATE;
+    size_t len = json_branding(NULL, cfg);
+    config_doc_t *doc = prov_malloc(sizeof(*doc) + len + 1);
+    if (!doc) {
+        return NULL;
     }
+    doc->len = json_branding(doc->json, cfg);
+    snprintf(doc->etag, sizeof(doc->etag), "\"%08x\"",
+             (unsigned)fnv1a(doc->json, doc->len));
+    return doc;
+}
+
+/*
+ * Runs in the server task, so no handler is using the old document. In
+ * the arena the old one is not the newest block, so its space only
+ * comes back when the portal stops (see CONFIG_WIFI_PROV_STATIC_ALLOC).
+ */
+static void config_doc_swap(void *arg)
+{
+    config_doc_t *old = s_config_doc;
+    s_config_doc = arg;
+    prov_free(old);
+}
 
-    s_page_config = page_config;
+esp_err_t http_server_update_branding(const wifi_prov_config_t *page_config)
+{
+    if (!s_server) {
+        return ESP_OK; /* rendered on the next start */
+    }
 
+    config_doc_t *doc = config_doc_render(page_config);
+    if (!doc) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = httpd_queue_work(s_server, config_doc_swap, doc);
+    if (err != ESP_OK) {
+        prov_free(doc);
+    }
+    return err;
+}
+
+/* ── Routes ─────────────────────────────────────────────────────────── */
+
+/* Route ids as recorded in STATS_HTTP_REQUEST events */
+enum {
+    ROUTE_ROOT,
+    ROUTE_CONFIG,
+    ROUTE_SCAN,
+    ROUTE_SAVE,
+    ROUTE_REDIRECT,
+    ROUTE_EVENTS,
+};
+
+typedef struct {
+    uint16_t id;
+    esp_err_t (*handler)(httpd_req_t *req);
+} route_t;
+
+static const route_t s_routes[] = {
+    [ROUTE_ROOT]     = { ROUTE_ROOT,     root_handler },
+    [ROUTE_CONFIG]   = { ROUTE_CONFIG,   config_handler },
+    [ROUTE_SCAN]     = { ROUTE_SCAN,     scan_handler },
+    [ROUTE_SAVE]     = { ROUTE_SAVE,     save_handler },
+    [ROUTE_REDIRECT] = { ROUTE_REDIRECT, redirect_handler },
+#if CONFIG_WIFI_PROV_STATS
+    [ROUTE_EVENTS]   = { ROUTE_EVENTS,   events_handler },
+#endif
+};
+
+/* Every route goes through here so its latency lands in the event log */
+static esp_err_t route_handler(httpd_req_t *req)
+{
+    const route_t *route = req->user_ctx;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t ret = route->handler(req);
+    stats_record(STATS_HTTP_REQUEST, route->id,
+                 (uint32_t)((esp_timer_get_time() - t0) / 1000));
+    return ret;
+}
+
+#define ROUTE(path, verb, id) {                                             \
+    .uri      = (path),                                                     \
+    .method   = (verb),                                                     \
+    .handler  = route_handler,                                              \
+    .user_ctx = (void *)&s_routes[id],                                      \
+}
+
+/* ── Start / Stop ───────────────────────────────────────────────────── */
+
+#if CONFIG_WIFI_PROV_HTTPS
+/*
+ * Plain HTTP listener that only redirects to the HTTPS portal. Captive
+ * portal probes from client OSes always arrive over HTTP.
+ */
+static esp_err_t redirect_server_start(uint16_t port)
+{
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port     = port;
-    config.uri_match_fn    = httpd_uri_match_wildcard;
+    config.server_port      = port;
+    config.ctrl_port        = config.ctrl_port + 1; /* HTTPS server owns the default */
+    config.uri_match_fn     = httpd_uri_match_wildcard;
     config.lru_purge_enable = true;
+    config.max_uri_handlers = 2;
 
-    esp_err_t err = httpd_start(&s_server, &config);
+    esp_err_t err = httpd_start(&s_redirect_server, &config);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start HTTP server (%s)", esp_err_to_name(err));
         return err;
     }
 
-    const httpd_uri_t uri_root = {
-        .uri     = "/",
-        .method  = HTTP_GET,
-        .handler = root_handler,
-    };
-    const httpd_uri_t uri_scan = {
-        .uri     = "/scan",
-        .method  = HTTP_GET,
-        .handler = scan_handler,
-    };
-    const httpd_uri_t uri_save = {
-        .uri     = "/save",
-        .method  = HTTP_POST,
-        .handler = save_handler,
-    };
-    const httpd_uri_t uri_config = {
-        .uri     = "/config",
-        .method  = HTTP_GET,
-        .handler = config_handler,
-    };
-    const httpd_uri_t uri_catch_all_get = {
+    const httpd_uri_t uri_redirect_get = {
         .uri     = "/*",
         .method  = HTTP_GET,
         .handler = redirect_handler,
     };
-    const httpd_uri_t uri_catch_all_post = {
+    const httpd_uri_t uri_redirect_post = {
         .uri     = "/*",
         .method  = HTTP_POST,
         .handler = redirect_handler,
     };
 
-    httpd_register_uri_handler(s_server, &uri_root);
-    httpd_register_uri_handler(s_server, &uri_config);
-    httpd_register_uri_handler(s_server, &uri_scan);
-    httpd_register_uri_handler(s_server, &uri_save);
-    httpd_register_uri_handler(s_server, &uri_catch_all_get);
-    httpd_register_uri_handler(s_server, &uri_catch_all_post);
+    httpd_register_uri_handler(s_redirect_server, &uri_redirect_get);
+    httpd_register_uri_handler(s_redirect_server, &uri_redirect_post);
+    return ESP_OK;
+}
 
+static esp_err_t portal_server_start(uint16_t port)
+{
+    esp_err_t err = tls_cert_load(&s_cert);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    httpd_ssl_config_t config = HTTPD_SSL_CONFIG_DEFAULT();
+    config.httpd.uri_match_fn     = httpd_uri_match_wildcard;
+    config.httpd.lru_purge_enable = true;
+    config.port_secure    = CONFIG_WIFI_PROV_HTTPS_PORT;
+    config.servercert     = (const uint8_t *)s_cert.cert_pem;
+    config.servercert_len = s_cert.cert_len;
+    config.prvtkey_pem    = (const uint8_t *)s_cert.key_pem;
+    config.prvtkey_len    = s_cert.key_len;
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    /* Resume sessions so the page's follow-up fetches skip the full handshake */
+    config.session_tickets = true;
+#endif
+
+    err = httpd_ssl_start(&s_server, &config);
+    if (err != ESP_OK) {
+        tls_cert_free(&s_cert);
+        return err;
+    }
+
+    err = redirect_server_start(port);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "HTTP redirect unavailable (%s)", esp_err_to_name(err));
+    }
+    return ESP_OK;
+}
+#else
+static esp_err_t portal_server_start(uint16_t port)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port     = port;
+    config.uri_match_fn    = httpd_uri_match_wildcard;
+    config.lru_purge_enable = true;
+
+    return httpd_start(&s_server, &config);
+}
+#endif
+
+esp_err_t http_server_start(uint16_t port, const wifi_prov_config_t *page_config)
+{
+    if (s_server) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_config_doc = config_doc_render(page_config);
+    if (!s_config_doc) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = portal_server_start(port);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP server (%s)", esp_err_to_name(err));
+        prov_free(s_config_doc);
+        s_config_doc = NULL;
+        return err;
+    }
+
+    const httpd_uri_t uris[] = {
+        ROUTE("/",       HTTP_GET,  ROUTE_ROOT),
+        ROUTE("/config", HTTP_GET,  ROUTE_CONFIG),
+        ROUTE("/scan",   HTTP_GET,  ROUTE_SCAN),
+        ROUTE("/save",   HTTP_POST, ROUTE_SAVE),
+#if CONFIG_WIFI_PROV_STATS
+        ROUTE("/debug/events", HTTP_GET, ROUTE_EVENTS),
+#endif
+        /* Catch-alls last: wildcard matching is first-registered-wins */
+        ROUTE("/*",      HTTP_GET,  ROUTE_REDIRECT),
+        ROUTE("/*",      HTTP_POST, ROUTE_REDIRECT),
+    };
+
+    for (int i = 0; i < (int)(sizeof(uris) / sizeof(uris[0])); i++) {
+        httpd_register_uri_handler(s_server, &uris[i]);
+    }
+
+#if CONFIG_WIFI_PROV_HTTPS
+    ESP_LOGI(TAG, "HTTPS server started on port %d", CONFIG_WIFI_PROV_HTTPS_PORT);
+#else
     ESP_LOGI(TAG, "HTTP server started on port %d", port);
+#endif
     return ESP_OK;
 }
 
@@ -306,8 +494,19 @@ esp_err_t http_server_stop(void)
     if (!s_server) {
         return ESP_OK;
     }
+#if CONFIG_WIFI_PROV_HTTPS
+    if (s_redirect_server) {
+        httpd_stop(s_redirect_server);
+        s_redirect_server = NULL;
+    }
+    esp_err_t err = httpd_ssl_stop(s_server);
+    tls_cert_free(&s_cert);
+#else
     esp_err_t err = httpd_stop(s_server);
+#endif
     s_server = NULL;
+    prov_free(s_config_doc);
+    s_config_doc = NULL;
     ESP_LOGI(TAG, "HTTP server stopped");
     return err;
 }
@@ -8,16 +8,164 @@
 #include "wifi_prov_internal.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include "esp_timer.h"
 
 #define NVS_NAMESPACE "wifi_prov"
 #define NVS_KEY_SSID  "ssid"
 #define NVS_KEY_PASS  "pass"
+#define NVS_KEY_PASS_ENC "pass_enc"
+#define NVS_KEY_PMK   "pmk"
+#define NVS_KEY_AUTH  "auth"
+#define NVS_KEY_BSSID "bssid"
+#define NVS_KEY_CHAN  "chan"
+
+#define SECRET_MAX    sizeof(pmk_record_t)
+
+/* Kept in its own namespace so erasing credentials keeps the certificate */
+#define NVS_TLS_NAMESPACE "wifi_prov_tls"
+#define NVS_KEY_CERT      "cert"
+#define NVS_KEY_KEY       "key"
 
 static const char *TAG = "wifi_prov_nvs";
 
-esp_err_t nvs_store_load(char *ssid, size_t ssid_len,
-                         char *password, size_t pass_len)
+/* PMK together with the SSID it was derived for (the SSID is the PBKDF2 salt) */
+typedef struct {
+    char    ssid[33];
+    uint8_t pmk[WIFI_PMK_LEN];
+} pmk_record_t;
+
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+
+static wifi_prov_key_provider_t s_key_provider = crypto_efuse_key;
+static crypto_key_t             s_key;
+
+/* Derive the storage key on first use and keep it for the rest of the boot */
+static esp_err_t storage_key(crypto_key_t **key)
+{
+    if (!s_key.ready) {
+        uint8_t material[CRYPTO_KEY_LEN];
+        esp_err_t err = s_key_provider(material);
+        if (err == ESP_OK) {
+            err = crypto_key_init(&s_key, material);
+        }
+        memset(material, 0, sizeof(material));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to obtain storage key (%s)", esp_err_to_name(err));
+            return err;
+        }
+    }
+    *key = &s_key;
+    return ESP_OK;
+}
+
+static esp_err_t get_secret(nvs_handle_t handle, const char *nvs_key,
+                            const char *aad, void *out, size_t *len)
 {
+    uint8_t blob[SECRET_MAX + CRYPTO_OVERHEAD];
+    size_t  blob_len = sizeof(blob);
+    esp_err_t err = nvs_get_blob(handle, nvs_key, blob, &blob_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    crypto_key_t *key;
+    err = storage_key(&key);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return crypto_open(key, blob, blob_len, aad, strlen(aad), out, len);
+}
+
+static esp_err_t set_secret(nvs_handle_t handle, const char *nvs_key,
+                            const char *aad, const void *data, size_t len)
+{
+    crypto_key_t *key;
+    esp_err_t err = storage_key(&key);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t blob[SECRET_MAX + CRYPTO_OVERHEAD];
+    size_t  blob_len = sizeof(blob);
+    err = crypto_seal(key, data, len, aad, strlen(aad), blob, &blob_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return nvs_set_blob(handle, nvs_key, blob, blob_len);
+}
+
+/* The SSID is bound as associated data so a blob cannot be moved to another record */
+static esp_err_t load_password(nvs_handle_t handle, const char *ssid,
+                               char *password, size_t pass_len)
+{
+    size_t len = pass_len - 1;
+    esp_err_t err = get_secret(handle, NVS_KEY_PASS_ENC, ssid, password, &len);
+    if (err == ESP_OK) {
+        password[len] = '\0';
+    }
+    return err;
+}
+
+static esp_err_t save_password(nvs_handle_t handle, const char *ssid,
+                               const char *password)
+{
+    esp_err_t err = set_secret(handle, NVS_KEY_PASS_ENC, ssid,
+                               password, strlen(password));
+    if (err == ESP_OK) {
+        /* Drop any plaintext copy left by a build without encryption */
+        esp_err_t erase = nvs_erase_key(handle, NVS_KEY_PASS);
+        if (erase != ESP_OK && erase != ESP_ERR_NVS_NOT_FOUND) {
+            err = erase;
+        }
+    }
+    return err;
+}
+
+#else
+
+static esp_err_t get_secret(nvs_handle_t handle, const char *nvs_key,
+                            const char *aad, void *out, size_t *len)
+{
+    return nvs_get_blob(handle, nvs_key, out, len);
+}
+
+static esp_err_t set_secret(nvs_handle_t handle, const char *nvs_key,
+                            const char *aad, const void *data, size_t len)
+{
+    return nvs_set_blob(handle, nvs_key, data, len);
+}
+
+static esp_err_t load_password(nvs_handle_t handle, const char *ssid,
+                               char *password, size_t pass_len)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+static esp_err_t save_password(nvs_handle_t handle, const char *ssid,
+                               const char *password)
+{
+    return nvs_set_str(handle, NVS_KEY_PASS, password);
+}
+
+#endif /* CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS */
+
+void nvs_store_set_key_provider(wifi_prov_key_provider_t provider)
+{
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    s_key_provider = provider ? provider : crypto_efuse_key;
+    crypto_key_free(&s_key);
+#endif
+}
+
+static esp_err_t save_creds(const wifi_prov_creds_t *creds);
+
+static esp_err_t load_creds(wifi_prov_creds_t *creds)
+{
+    char  *ssid     = creds->ssid;
+    char  *password = creds->password;
+    size_t ssid_len = sizeof(creds->ssid);
+    size_t pass_len = sizeof(creds->password);
+
     nvs_handle_t handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
     if (err != ESP_OK) {
@@ -32,20 +180,50 @@ esp_err_t nvs_store_load(char *ssid, size_t ssid_len,
         return err;
     }
 
-    err = nvs_get_str(handle, NVS_KEY_PASS, password, &pass_len);
+    bool plaintext = false;
+    err = load_password(handle, ssid, password, pass_len);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        plaintext = true;
+        err = nvs_get_str(handle, NVS_KEY_PASS, password, &pass_len);
+    }
     if (err != ESP_OK) {
         ESP_LOGD(TAG, "No stored password (%s)", esp_err_to_name(err));
         nvs_close(handle);
         return err;
     }
 
+    /* Records saved before the auth mode was stored leave it unknown */
+    uint8_t authmode;
+    creds->authmode = nvs_get_u8(handle, NVS_KEY_AUTH, &authmode) == ESP_OK
+                          ? (wifi_auth_mode_t)authmode : WIFI_AUTH_MAX;
+
+    /* Optional AP pin */
+    size_t bssid_len = sizeof(creds->bssid);
+    creds->bssid_set = nvs_get_blob(handle, NVS_KEY_BSSID, creds->bssid, &bssid_len) == ESP_OK &&
+                       bssid_len == sizeof(creds->bssid);
+    if (nvs_get_u8(handle, NVS_KEY_CHAN, &creds->channel) != ESP_OK) {
+        creds->channel = 0;
+    }
+
     nvs_close(handle);
     ESP_LOGI(TAG, "Loaded credentials for SSID \"%s\"", ssid);
+
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    if (plaintext) {
+        ESP_LOGI(TAG, "Encrypting plaintext credentials");
+        save_creds(creds);
+    }
+#else
+    (void)plaintext;
+#endif
     return ESP_OK;
 }
 
-esp_err_t nvs_store_save(const char *ssid, const char *password)
+static esp_err_t save_creds(const wifi_prov_creds_t *creds)
 {
+    const char *ssid     = creds->ssid;
+    const char *password = creds->password;
+
     nvs_handle_t handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
     if (err != ESP_OK) {
@@ -60,13 +238,59 @@ esp_err_t nvs_store_save(const char *ssid, const char *password)
         return err;
     }
 
-    err = nvs_set_str(handle, NVS_KEY_PASS, password);
+    err = save_password(handle, ssid, password);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to save password (%s)", esp_err_to_name(err));
         nvs_close(handle);
         return err;
     }
 
+    if (creds->authmode < WIFI_AUTH_MAX) {
+        err = nvs_set_u8(handle, NVS_KEY_AUTH, (uint8_t)creds->authmode);
+    } else {
+        err = nvs_erase_key(handle, NVS_KEY_AUTH);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save auth mode (%s)", esp_err_to_name(err));
+        nvs_close(handle);
+        return err;
+    }
+
+    /*
+     * Derive the PMK now so later boots can hand it to the driver and
+     * skip the 4096-round PBKDF2. Only WPA passphrases (8..63 chars)
+     * need it, and only networks known to be WPA/WPA2-Personal can use
+     * it. A failure here just means the passphrase is used.
+     */
+    size_t pass_len = strlen(password);
+    pmk_record_t rec = {0};
+    strncpy(rec.ssid, ssid, sizeof(rec.ssid) - 1);
+    if (pass_len >= 8 && pass_len <= 63 &&
+        crypto_pmk_usable(creds->authmode) &&
+        crypto_wpa_pmk(ssid, password, rec.pmk) == ESP_OK) {
+        if (set_secret(handle, NVS_KEY_PMK, "", &rec, sizeof(rec)) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to save PMK");
+        }
+    } else {
+        nvs_erase_key(handle, NVS_KEY_PMK);
+    }
+    memset(&rec, 0, sizeof(rec));
+
+    /* Like the PMK the pin only speeds up the connect, so failures are not fatal */
+    esp_err_t pin_err = creds->bssid_set
+        ? nvs_set_blob(handle, NVS_KEY_BSSID, creds->bssid, sizeof(creds->bssid))
+        : nvs_erase_key(handle, NVS_KEY_BSSID);
+    if (pin_err == ESP_OK || pin_err == ESP_ERR_NVS_NOT_FOUND) {
+        pin_err = creds->channel ? nvs_set_u8(handle, NVS_KEY_CHAN, creds->channel)
+                                 : nvs_erase_key(handle, NVS_KEY_CHAN);
+    }
+    if (pin_err != ESP_OK && pin_err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "Failed to save AP pin (%s)", esp_err_to_name(pin_err));
+    }
+
     err = nvs_commit(handle);
     nvs_close(handle);
 
@@ -76,6 +300,55 @@ esp_err_t nvs_store_save(const char *ssid, const char *password)
     return err;
 }
 
+esp_err_t nvs_store_load(wifi_prov_creds_t *creds)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = load_creds(creds);
+    stats_record(STATS_NVS_LOAD, (uint16_t)err, (uint32_t)(esp_timer_get_time() - t0));
+    return err;
+}
+
+esp_err_t nvs_store_save(const wifi_prov_creds_t *creds)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = save_creds(creds);
+    stats_record(STATS_NVS_SAVE, (uint16_t)err, (uint32_t)(esp_timer_get_time() - t0));
+    return err;
+}
+
+esp_err_t nvs_store_load_pmk(const char *ssid, char *psk, size_t psk_len)
+{
+    if (psk_len < WIFI_PMK_LEN * 2 + 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pmk_record_t rec;
+    size_t len = sizeof(rec);
+    err = get_secret(handle, NVS_KEY_PMK, "", &rec, &len);
+    nvs_close(handle);
+
+    if (err == ESP_OK && (len != sizeof(rec) ||
+                          strncmp(rec.ssid, ssid, sizeof(rec.ssid)) != 0)) {
+        ESP_LOGD(TAG, "Stored PMK does not match SSID \"%s\"", ssid);
+        err = ESP_ERR_INVALID_STATE;
+    }
+
+    if (err == ESP_OK) {
+        /* 64 hex digits are taken by the driver as a raw PSK */
+        for (int i = 0; i < WIFI_PMK_LEN; i++) {
+            sprintf(psk + i * 2, "%02x", rec.pmk[i]);
+        }
+    }
+    memset(&rec, 0, sizeof(rec));
+    return err;
+}
+
 esp_err_t nvs_store_erase(void)
 {
     nvs_handle_t handle;
@@ -91,3 +364,49 @@ esp_err_t nvs_store_erase(void)
     ESP_LOGI(TAG, "Erased stored credentials");
     return err;
 }
+
+esp_err_t nvs_store_load_tls(char *cert, size_t *cert_len,
+                             char *key, size_t *key_len)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_TLS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "No stored certificate (nvs_open: %s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_get_str(handle, NVS_KEY_CERT, cert, cert_len);
+    if (err == ESP_OK) {
+        err = nvs_get_str(handle, NVS_KEY_KEY, key, key_len);
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "No stored certificate (%s)", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t nvs_store_save_tls(const char *cert, const char *key)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_TLS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_str(handle, NVS_KEY_CERT, cert);
+    if (err == ESP_OK) {
+        err = nvs_set_str(handle, NVS_KEY_KEY, key);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save certificate (%s)", esp_err_to_name(err));
+    }
+    return err;
+}
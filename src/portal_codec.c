@@ -0,0 +1,262 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Encoding and decoding on the portal's request paths: form fields,
+ * the /scan and /config JSON and DNS answers. Pure functions on caller buffers,
+ * no driver or server state, so they can be exercised in isolation.
+ */
+
+#include "wifi_prov_internal.h"
+
+#include <stdio.h>
+
+/* ── Form decoding ──────────────────────────────────────────────────── */
+
+int hex_val(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void url_decode(char *dst, size_t dst_len, const char *src, size_t src_len)
+{
+    size_t di = 0;
+    for (size_t si = 0; si < src_len && di < dst_len - 1; si++) {
+        if (src[si] == '+') {
+            dst[di++] = ' ';
+        } else if (src[si] == '%' && si + 2 < src_len) {
+            int hi = hex_val(src[si + 1]);
+            int lo = hex_val(src[si + 2]);
+            if (hi >= 0 && lo >= 0) {
+                dst[di++] = (char)((hi << 4) | lo);
+                si += 2;
+            } else {
+                dst[di++] = src[si];
+            }
+        } else {
+            dst[di++] = src[si];
+        }
+    }
+    dst[di] = '\0';
+}
+
+/*
+ * Decode field @p name from an x-www-form-urlencoded body. Only whole
+ * field names match, so "ssid" is not found inside "xssid=…".
+ */
+bool form_field(const char *body, const char *name, char *dst, size_t dst_len)
+{
+    size_t name_len = strlen(name);
+
+    for (const char *p = body; p; p = strchr(p, '&')) {
+        if (*p == '&') {
+            p++;
+        }
+        if (strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            const char *value = p + name_len + 1;
+            const char *end   = strchr(value, '&');
+            url_decode(dst, dst_len, value,
+                       end ? (size_t)(end - value) : strlen(value));
+            return true;
+        }
+    }
+    return false;
+}
+
+/* "aa:bb:cc:dd:ee:ff", '-' separators or none at all also accepted */
+bool parse_bssid(const char *str, uint8_t bssid[6])
+{
+    for (int i = 0; i < 6; i++) {
+        if (i > 0 && (*str == ':' || *str == '-')) {
+            str++;
+        }
+        int hi = hex_val(str[0]);
+        int lo = hi >= 0 ? hex_val(str[1]) : -1;
+        if (lo < 0) {
+            return false;
+        }
+        bssid[i] = (uint8_t)((hi << 4) | lo);
+        str += 2;
+    }
+    return *str == '\0';
+}
+
+/* ── JSON ───────────────────────────────────────────────────────────── */
+
+/* Longest escaped SSID: every byte as \u00XX */
+#define JSON_SSID_MAX   (32 * 6)
+#define JSON_NET_MAX    (JSON_SSID_MAX + sizeof("{\"ssid\":\"\",\"rssi\":-128,\"auth\":99," \
+                                            "\"bssid\":\"xx:xx:xx:xx:xx:xx\",\"ch\":255},"))
+
+/*
+ * Escape into dst (which must hold 6 bytes per input byte + 1), or with
+ * dst NULL only return the escaped length.
+ */
+static size_t json_escape(char *dst, const char *src)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t n = 0;
+
+    for (; *src; src++) {
+        unsigned char c = (unsigned char)*src;
+        if (c == '"' || c == '\\') {
+            if (dst) {
+                dst[n]     = '\\';
+                dst[n + 1] = (char)c;
+            }
+            n += 2;
+        } else if (c < 0x20) {
+            if (dst) {
+                memcpy(dst + n, "\\u00", 4);
+                dst[n + 4] = hex[c >> 4];
+                dst[n + 5] = hex[c & 0xF];
+            }
+            n += 6;
+        } else {
+            if (dst) {
+                dst[n] = (char)c;
+            }
+            n++;
+        }
+    }
+    if (dst) {
+        dst[n] = '\0';
+    }
+    return n;
+}
+
+size_t json_networks_max(uint16_t count)
+{
+    return 2 + count * JSON_NET_MAX + 1;
+}
+
+/*
+ * Buffer must hold json_networks_max(count) bytes; returns the length.
+ * Hidden networks also carry BSSID and channel, their only identity.
+ */
+size_t json_networks(char *buf, const wifi_scan_entry_t *nets, uint16_t count)
+{
+    char *p = buf;
+    *p++ = '[';
+    for (int i = 0; i < count; i++) {
+        if (i > 0) *p++ = ',';
+        p += sprintf(p, "{\"ssid\":\"");
+        p += json_escape(p, nets[i].ssid);
+        p += sprintf(p, "\",\"rssi\":%d,\"auth\":%d", nets[i].rssi, nets[i].authmode);
+        if (nets[i].ssid[0] == '\0') {
+            const uint8_t *b = nets[i].bssid;
+            p += sprintf(p, ",\"bssid\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"ch\":%u",
+                         b[0], b[1], b[2], b[3], b[4], b[5], nets[i].channel);
+        }
+        *p++ = '}';
+    }
+    *p++ = ']';
+    *p   = '\0';
+    return (size_t)(p - buf);
+}
+
+/*
+ * The /config document. With buf NULL only the length is computed, so
+ * the caller can allocate exactly len + 1 bytes for the second pass.
+ * NULL strings are sent as empty.
+ */
+size_t json_branding(char *buf, const wifi_prov_config_t *cfg)
+{
+    const struct {
+        const char *key;
+        const char *value;
+    } fields[] = {
+        { "title",               cfg->page_title },
+        { "portal_header",       cfg->portal_header },
+        { "portal_subheader",    cfg->portal_subheader },
+        { "connected_header",    cfg->connected_header },
+        { "connected_subheader", cfg->connected_subheader },
+        { "footer",              cfg->page_footer },
+    };
+
+    size_t n = 0;
+    for (int i = 0; i < (int)(sizeof(fields) / sizeof(fields[0])); i++) {
+        /* {"key":"value", — keys need no escaping */
+        const char *lead = i == 0 ? "{\"" : ",\"";
+        size_t key_len   = strlen(fields[i].key);
+        if (buf) {
+            memcpy(buf + n, lead, 2);
+            memcpy(buf + n + 2, fields[i].key, key_len);
+            memcpy(buf + n + 2 + key_len, "\":\"", 3);
+        }
+        n += 2 + key_len + 3;
+        n += json_escape(buf ? buf + n : NULL, fields[i].value ? fields[i].value : "");
+        if (buf) {
+            buf[n] = '"';
+        }
+        n++;
+    }
+    if (buf) {
+        memcpy(buf + n, "}", 2);
+    }
+    return n + 1;
+}
+
+/* FNV-1a, used as a strong-enough ETag for generated documents */
+uint32_t fnv1a(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint32_t hash = 0x811c9dc5;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+/* ── DNS ────────────────────────────────────────────────────────────── */
+
+#define DNS_HEADER_LEN 12
+#define DNS_ANSWER_LEN 16
+
+/*
+ * Turn the query in buf[0..len) into a reply in place: flip the header
+ * bits and append one A record pointing the question name at ip
+ * (network byte order). Returns the reply length, 0 if it cannot be
+ * answered within cap bytes.
+ */
+size_t dns_build_response(uint8_t *buf, size_t len, size_t cap, uint32_t ip)
+{
+    if (len < DNS_HEADER_LEN || len + DNS_ANSWER_LEN > cap) {
+        return 0;
+    }
+
+    buf[2] = 0x81; /* QR=1, Opcode=0, AA=1 */
+    buf[3] = 0x80; /* RA=1, RCODE=0 (No error) */
+    /* Answer count = 1 */
+    buf[6] = 0x00;
+    buf[7] = 0x01;
+
+    /* Append answer section right after the query */
+    uint8_t *p = buf + len;
+
+    /* Name pointer to the question name (offset 12) */
+    *p++ = 0xC0;
+    *p++ = 0x0C;
+    /* Type A */
+    *p++ = 0x00;
+    *p++ = 0x01;
+    /* Class IN */
+    *p++ = 0x00;
+    *p++ = 0x01;
+    /* TTL = 60 seconds */
+    *p++ = 0x00;
+    *p++ = 0x00;
+    *p++ = 0x00;
+    *p++ = 0x3C;
+    /* Data length = 4 */
+    *p++ = 0x00;
+    *p++ = 0x04;
+    /* IP address */
+    memcpy(p, &ip, 4);
+    p += 4;
+
+    return (size_t)(p - buf);
+}
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Transport-independent credential pipeline: validate, trial connect,
+ * persist and hand off to the orchestrator. Every transport (HTTP
+ * portal, BLE) feeds received credentials through here.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_event.h"
+
+#include <ctype.h>
+
+static const char *TAG = "wifi_prov";
+
+/* ── Event posted when a transport delivered working credentials ────── */
+
+ESP_EVENT_DEFINE_BASE(WIFI_PROV_EVENT);
+
+/* ── Pipeline ───────────────────────────────────────────────────────── */
+
+static bool is_hex_psk(const char *password, size_t len)
+{
+    if (len != 64) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isxdigit((unsigned char)password[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t validate(const wifi_prov_creds_t *creds)
+{
+    size_t ssid_len = strnlen(creds->ssid, sizeof(creds->ssid));
+    size_t pass_len = strnlen(creds->password, sizeof(creds->password));
+
+    if (ssid_len == 0 || ssid_len > 32 || creds->channel > 14) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Open network, WPA passphrase, or a raw 64-digit hex PSK */
+    if (pass_len != 0 && (pass_len < 8 || pass_len > 63) &&
+        !is_hex_psk(creds->password, pass_len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t provision_apply(wifi_prov_creds_t *creds)
+{
+    esp_err_t err = validate(creds);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected malformed credentials");
+        return err;
+    }
+
+    /*
+     * Security settings for the connect come from the scanned network.
+     * A hidden network is only in the cache by BSSID, so without a pin
+     * it is not found and connects with the configured floor.
+     */
+    wifi_scan_entry_t net;
+    bool found = creds->bssid_set
+        ? wifi_scan_cache_find_bssid(creds->bssid, &net) &&
+          (net.ssid[0] == '\0' || strcmp(net.ssid, creds->ssid) == 0)
+        : wifi_scan_cache_find(creds->ssid, &net);
+    creds->authmode = found ? net.authmode : WIFI_AUTH_MAX;
+    if (found && creds->bssid_set && creds->channel == 0) {
+        creds->channel = net.channel; /* saved with the pin */
+    }
+    if (creds->channel || found) {
+        wifi_ap_follow_channel(creds->channel ? creds->channel : net.channel);
+    }
+
+    err = wifi_sta_try_connect(creds);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_store_save(creds);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Connected, but credentials were not saved");
+    }
+    return ESP_OK;
+}
+
+void provision_complete(const wifi_prov_creds_t *creds)
+{
+    /*
+     * Post event so the orchestrator can tear down the transport. Any
+     * handler on the default loop sees the payload, so it is the SSID
+     * alone; the password stays with the driver and NVS.
+     */
+    esp_event_post(WIFI_PROV_EVENT, WIFI_PROV_EVENT_CREDENTIALS_SET,
+                   creds->ssid, strnlen(creds->ssid, sizeof(creds->ssid) - 1) + 1,
+                   pdMS_TO_TICKS(100));
+}
+
+/* ── HTTP captive portal transport ──────────────────────────────────── */
+
+static esp_err_t http_transport_start(const wifi_prov_config_t *config)
+{
+    esp_err_t err = wifi_ap_start(config);
+    if (err == ESP_OK) {
+        err = dns_server_start();
+    }
+    if (err == ESP_OK) {
+        err = http_server_start(config->http_port, config);
+    }
+    return err;
+}
+
+static esp_err_t http_transport_stop(void)
+{
+    http_server_stop();
+    dns_server_stop();
+    return wifi_ap_dispose();
+}
+
+const prov_transport_t prov_transport_http = {
+    .name  = "captive portal",
+    .start = http_transport_start,
+    .stop  = http_transport_stop,
+};
+
+/* ── Transport registry ─────────────────────────────────────────────── */
+
+static const prov_transport_t *s_transports[] = {
+    [WIFI_PROV_TRANSPORT_HTTP] = &prov_transport_http,
+#if CONFIG_WIFI_PROV_TRANSPORT_BLE
+    [WIFI_PROV_TRANSPORT_BLE]  = &prov_transport_ble,
+#endif
+};
+
+#define TRANSPORT_COUNT (sizeof(s_transports) / sizeof(s_transports[0]))
+
+esp_err_t provision_register_transport(wifi_prov_transport_t id,
+                                       const prov_transport_t *transport)
+{
+    if ((size_t)id >= TRANSPORT_COUNT || !transport) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_transports[id] = transport;
+    return ESP_OK;
+}
+
+const prov_transport_t *provision_transport(wifi_prov_transport_t id)
+{
+    return (size_t)id < TRANSPORT_COUNT ? s_transports[id] : NULL;
+}
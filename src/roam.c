@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Roaming for the connected station (CONFIG_WIFI_PROV_ROAMING).
+ *
+ * 802.11k/v/r are enabled in the STA config (see wifi_sta.c), so the
+ * supplicant follows BSS transition requests from the AP and uses fast
+ * transition where the network offers it. This adds the triggers: when
+ * the signal drops below the threshold a BTM-capable AP is asked for a
+ * transition, other APs get a scan and a move to a clearly stronger AP
+ * of the same network. Dropped links are reconnected, backing off while
+ * the network stays out of reach; a disconnect the application asked
+ * for is left alone.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_wifi.h"
+#include "esp_wnm.h"
+#include "esp_timer.h"
+
+#define ROAM_HYSTERESIS_DB  8       /* a candidate must be this much stronger */
+#define ROAM_COOLDOWN_MS    10000   /* between two low-RSSI triggers */
+#define ROAM_QUERY_MS       5000    /* an unanswered BTM query is given up after */
+#define RECONNECT_MIN_MS    500     /* first back-off after a failed reconnect */
+#define RECONNECT_MAX_MS    30000
+
+static const char *TAG = "wifi_prov_roam";
+
+static bool               s_active = false;
+static uint8_t            s_bssid[6];          /* current AP */
+static int64_t            s_roam_start = -1;   /* µs, -1 = not roaming */
+static bool               s_link_lost;
+static bool               s_leaving;           /* the next disconnect is our own */
+static uint32_t           s_backoff_ms;        /* before the next reconnect, 0 = none yet */
+static esp_timer_handle_t s_rearm_timer = NULL;
+static esp_timer_handle_t s_reconnect_timer = NULL;
+static esp_event_handler_instance_t s_wifi_handler;
+
+/* The threshold event fires once; arm it again after the cooldown */
+static void rearm(void *arg)
+{
+    if (s_active) {
+        esp_wifi_set_rssi_threshold(CONFIG_WIFI_PROV_ROAM_RSSI);
+    }
+}
+
+static void reconnect(void *arg)
+{
+    if (s_active) {
+        esp_wifi_connect();
+    }
+}
+
+/* At once after the first drop, then doubling up to RECONNECT_MAX_MS */
+static void schedule_reconnect(void)
+{
+    if (s_backoff_ms == 0) {
+        s_backoff_ms = RECONNECT_MIN_MS;
+        esp_wifi_connect();
+        return;
+    }
+
+    ESP_LOGD(TAG, "Reconnecting in %u ms", (unsigned)s_backoff_ms);
+    esp_timer_stop(s_reconnect_timer);
+    esp_timer_start_once(s_reconnect_timer, (uint64_t)s_backoff_ms * 1000);
+    s_backoff_ms = s_backoff_ms * 2 < RECONNECT_MAX_MS ? s_backoff_ms * 2 : RECONNECT_MAX_MS;
+}
+
+/* Drop the BSSID pin so the next connect may pick any AP of the network */
+static void unpin(void)
+{
+    wifi_config_t cfg;
+    if (esp_wifi_get_config(WIFI_IF_STA, &cfg) == ESP_OK && cfg.sta.bssid_set) {
+        cfg.sta.bssid_set = false;
+        cfg.sta.channel   = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    }
+}
+
+/* Scan-based roam for APs without BSS transition management */
+static void on_scan(esp_err_t status, const wifi_prov_network_t *networks,
+                    uint16_t count, void *arg)
+{
+    wifi_ap_record_t current;
+    if (!s_active || status != ESP_OK || esp_wifi_sta_get_ap_info(&current) != ESP_OK) {
+        s_roam_start = -1;
+        return;
+    }
+
+    /* One entry per SSID, the strongest AP; the filter is only a prefix */
+    const wifi_prov_network_t *best = NULL;
+    for (int i = 0; i < count && !best; i++) {
+        if (strcmp(networks[i].ssid, (const char *)current.ssid) == 0) {
+            best = &networks[i];
+        }
+    }
+    if (!best || memcmp(best->bssid, current.bssid, sizeof(current.bssid)) == 0 ||
+        best->rssi < current.rssi + ROAM_HYSTERESIS_DB) {
+        ESP_LOGD(TAG, "No better AP than the current one (%d dBm)", current.rssi);
+        s_roam_start = -1;
+        return;
+    }
+
+    ESP_LOGI(TAG, "Moving to " MACSTR " (%d dBm, channel %d) …",
+             MAC2STR(best->bssid), best->rssi, best->channel);
+
+    wifi_config_t cfg;
+    if (esp_wifi_get_config(WIFI_IF_STA, &cfg) != ESP_OK) {
+        s_roam_start = -1;
+        return;
+    }
+    memcpy(cfg.sta.bssid, best->bssid, sizeof(cfg.sta.bssid));
+    cfg.sta.bssid_set = true;
+    cfg.sta.channel   = best->channel;
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+
+    /* The reconnect path below associates with the new config */
+    s_leaving = true;
+    esp_wifi_disconnect();
+}
+
+static void on_rssi_low(const wifi_event_bss_rssi_low_t *event)
+{
+    ESP_LOGI(TAG, "Signal at %d dBm, looking for a better AP …", (int)event->rssi);
+    s_roam_start = esp_timer_get_time();
+    s_link_lost  = false;
+
+    /* A BTM-capable AP answers with a transition request the supplicant follows */
+    if (!esp_wnm_is_btm_supported_connection() ||
+        esp_wnm_send_bss_transition_mgmt_query(REASON_FRAME_LOSS, NULL, 0) != 0) {
+        wifi_ap_record_t current;
+        wifi_prov_scan_filter_t filter = WIFI_PROV_SCAN_FILTER_DEFAULT();
+        if (esp_wifi_sta_get_ap_info(&current) == ESP_OK) {
+            filter.ssid_prefix = (const char *)current.ssid;
+        }
+        if (wifi_scan_async(&filter, on_scan, NULL) != ESP_OK) {
+            s_roam_start = -1;
+        }
+    }
+
+    esp_timer_stop(s_rearm_timer);
+    esp_timer_start_once(s_rearm_timer, (uint64_t)ROAM_COOLDOWN_MS * 1000);
+}
+
+static void on_wifi_event(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    /* A BTM query the AP never answered: no roam is under way after all */
+    if (s_roam_start >= 0 && !s_link_lost &&
+        esp_timer_get_time() - s_roam_start > (int64_t)ROAM_QUERY_MS * 1000) {
+        s_roam_start = -1;
+    }
+
+    switch (id) {
+    case WIFI_EVENT_STA_BSS_RSSI_LOW:
+        on_rssi_low(data);
+        break;
+
+    case WIFI_EVENT_STA_DISCONNECTED: {
+        const wifi_event_sta_disconnected_t *event = data;
+        bool own = s_leaving;
+        s_leaving = false;
+        if (event->reason == WIFI_REASON_ASSOC_LEAVE && !own) {
+            /* The application disconnected: leave the link down */
+            ESP_LOGI(TAG, "Disconnected on request, not reconnecting");
+            esp_timer_stop(s_reconnect_timer);
+            s_roam_start = -1;
+            s_link_lost  = false;
+            break;
+        }
+        if (s_link_lost) {
+            /* The chosen AP did not take us back: any AP of the network will do */
+            unpin();
+        }
+        if (s_roam_start < 0) {
+            s_roam_start = esp_timer_get_time();
+        }
+        s_link_lost = true;
+        schedule_reconnect();
+        break;
+    }
+
+    case WIFI_EVENT_STA_CONNECTED: {
+        const wifi_event_sta_connected_t *event = data;
+        if (s_roam_start >= 0 && memcmp(event->bssid, s_bssid, sizeof(s_bssid)) != 0) {
+            uint32_t ms = (uint32_t)((esp_timer_get_time() - s_roam_start) / 1000);
+            ESP_LOGI(TAG, "Roamed to " MACSTR " in %u ms%s", MAC2STR(event->bssid),
+                     (unsigned)ms, s_link_lost ? "" : " without dropping the link");
+            stats_record(STATS_ROAM, s_link_lost, ms);
+        }
+        memcpy(s_bssid, event->bssid, sizeof(s_bssid));
+        s_roam_start = -1;
+        s_link_lost  = false;
+        s_backoff_ms = 0;
+        esp_timer_stop(s_reconnect_timer);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+/* Connected and no portal running: watch the link */
+esp_err_t roam_start(void)
+{
+    if (s_active) {
+        return ESP_OK;
+    }
+
+    if (!s_rearm_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = rearm,
+            .name     = "wifi_prov_roam",
+        };
+        esp_err_t err = esp_timer_create(&args, &s_rearm_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (!s_reconnect_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = reconnect,
+            .name     = "wifi_prov_reconnect",
+        };
+        esp_err_t err = esp_timer_create(&args, &s_reconnect_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    wifi_ap_record_t current;
+    if (esp_wifi_sta_get_ap_info(&current) == ESP_OK) {
+        memcpy(s_bssid, current.bssid, sizeof(s_bssid));
+    }
+    s_roam_start = -1;
+    s_link_lost  = false;
+    s_leaving    = false;
+    s_backoff_ms = 0;
+
+    esp_err_t err = esp_event_handler_instance_register(
+        WIFI_EVENT, ESP_EVENT_ANY_ID, on_wifi_event, NULL, &s_wifi_handler);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_active = true;
+    esp_wifi_set_rssi_threshold(CONFIG_WIFI_PROV_ROAM_RSSI);
+
+    ESP_LOGI(TAG, "Roaming below %d dBm", CONFIG_WIFI_PROV_ROAM_RSSI);
+    return ESP_OK;
+}
+
+/* Before anything else drives the STA (trial connects, shutdown) */
+void roam_stop(void)
+{
+    if (!s_active) {
+        return;
+    }
+    s_active = false;
+    esp_timer_stop(s_rearm_timer);
+    esp_timer_stop(s_reconnect_timer);
+    esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, s_wifi_handler);
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Provisioner event log: per-event counters and a ring of the most
+ * recent events, for post-mortem analysis of field failures.
+ *
+ * Writers never lock: a slot is claimed with an atomic increment and
+ * published by storing its sequence number last. Readers skip slots
+ * that are being rewritten while they look.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_timer.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define RING_SIZE CONFIG_WIFI_PROV_STATS_EVENTS
+
+_Static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "ring size must be a power of two");
+
+typedef struct {
+    atomic_uint seq;        /* index + 1 once published, 0 = empty */
+    uint32_t    time_ms;
+    uint8_t     type;
+    uint16_t    a;
+    uint32_t    b;
+} stats_slot_t;
+
+static stats_slot_t s_ring[RING_SIZE];
+static atomic_uint  s_head;
+static atomic_uint  s_counters[STATS_EVENT_MAX];
+
+static const char *const s_names[STATS_EVENT_MAX] = {
+    [STATS_DNS_QUERY]      = "dns_query",
+    [STATS_HTTP_REQUEST]   = "http_request",
+    [STATS_SCAN]           = "scan",
+    [STATS_STA_CONNECT]    = "sta_connect",
+    [STATS_STA_DISCONNECT] = "sta_disconnect",
+    [STATS_NVS_LOAD]       = "nvs_load",
+    [STATS_NVS_SAVE]       = "nvs_save",
+    [STATS_ROAM]           = "roam",
+};
+
+void stats_record(stats_event_t type, uint16_t a, uint32_t b)
+{
+    unsigned idx = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    stats_slot_t *slot = &s_ring[idx & (RING_SIZE - 1)];
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    slot->type    = (uint8_t)type;
+    slot->a       = a;
+    slot->b       = b;
+    atomic_store_explicit(&slot->seq, idx + 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&s_counters[type], 1, memory_order_relaxed);
+}
+
+/* snprintf that keeps counting once the buffer is full */
+static size_t append(char *buf, size_t len, size_t pos, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(pos < len ? buf + pos : NULL, pos < len ? len - pos : 0, fmt, ap);
+    va_end(ap);
+    return pos + (n > 0 ? n : 0);
+}
+
+size_t stats_dump(char *buf, size_t len)
+{
+    size_t pos = append(buf, len, 0, "{\"counters\":{");
+    for (int i = 0; i < STATS_EVENT_MAX; i++) {
+        pos = append(buf, len, pos, "%s\"%s\":%u", i ? "," : "", s_names[i],
+                     atomic_load_explicit(&s_counters[i], memory_order_relaxed));
+    }
+    pos = append(buf, len, pos, "},\"events\":[");
+
+    unsigned head  = atomic_load_explicit(&s_head, memory_order_acquire);
+    unsigned first = head > RING_SIZE ? head - RING_SIZE : 0;
+    bool     comma = false;
+
+    for (unsigned idx = first; idx < head; idx++) {
+        stats_slot_t *slot = &s_ring[idx & (RING_SIZE - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != idx + 1) {
+            continue; /* not yet published or already overwritten */
+        }
+        uint32_t time_ms = slot->time_ms;
+        uint8_t  type    = slot->type;
+        uint16_t a       = slot->a;
+        uint32_t b       = slot->b;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != idx + 1 ||
+            type >= STATS_EVENT_MAX) {
+            continue; /* rewritten while reading */
+        }
+
+        pos = append(buf, len, pos, "%s{\"t\":%u,\"ev\":\"%s\",\"a\":%u,\"b\":%u}",
+                     comma ? "," : "", (unsigned)time_ms, s_names[type],
+                     (unsigned)a, (unsigned)b);
+        comma = true;
+    }
+    pos = append(buf, len, pos, "]}");
+    return pos;
+}
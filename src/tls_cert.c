@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Self-signed ECDSA P-256 certificate for the HTTPS portal.
+ * Generated once and persisted in NVS so later boots only load it.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_timer.h"
+#include "mbedtls/version.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+
+#define CERT_PEM_MAX  1024
+#define KEY_PEM_MAX   512
+#define CERT_SUBJECT  "CN=192.168.4.1,O=WiFi Provisioner"
+
+static const char *TAG = "wifi_prov_tls";
+
+static esp_err_t generate(char *cert, size_t cert_len, char *key, size_t key_len)
+{
+    mbedtls_entropy_context  entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_pk_context       pk;
+    mbedtls_x509write_cert   crt;
+    unsigned char            serial[8];
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_pk_init(&pk);
+    mbedtls_x509write_crt_init(&crt);
+
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                    (const unsigned char *)TAG, strlen(TAG));
+    if (ret == 0) {
+        ret = mbedtls_pk_setup(&pk, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    }
+    if (ret == 0) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03050000
+        mbedtls_ecp_keypair *ec = mbedtls_pk_ec_rw(pk);
+#else
+        mbedtls_ecp_keypair *ec = mbedtls_pk_ec(pk);
+#endif
+        ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, ec,
+                                  mbedtls_ctr_drbg_random, &drbg);
+    }
+    if (ret == 0) {
+        ret = mbedtls_ctr_drbg_random(&drbg, serial, sizeof(serial));
+        serial[0] &= 0x7F; /* keep the serial positive */
+    }
+    if (ret == 0) {
+        mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+        mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+        mbedtls_x509write_crt_set_subject_key(&crt, &pk);
+        mbedtls_x509write_crt_set_issuer_key(&crt, &pk);
+        ret = mbedtls_x509write_crt_set_subject_name(&crt, CERT_SUBJECT);
+    }
+    if (ret == 0) {
+        ret = mbedtls_x509write_crt_set_issuer_name(&crt, CERT_SUBJECT);
+    }
+    if (ret == 0) {
+        ret = mbedtls_x509write_crt_set_validity(&crt, "20260101000000",
+                                                 "20991231235959");
+    }
+    if (ret == 0) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03040000
+        ret = mbedtls_x509write_crt_set_serial_raw(&crt, serial, sizeof(serial));
+#else
+        mbedtls_mpi mpi;
+        mbedtls_mpi_init(&mpi);
+        ret = mbedtls_mpi_read_binary(&mpi, serial, sizeof(serial));
+        if (ret == 0) {
+            ret = mbedtls_x509write_crt_set_serial(&crt, &mpi);
+        }
+        mbedtls_mpi_free(&mpi);
+#endif
+    }
+    if (ret == 0) {
+        ret = mbedtls_x509write_crt_pem(&crt, (unsigned char *)cert, cert_len,
+                                        mbedtls_ctr_drbg_random, &drbg);
+    }
+    if (ret == 0) {
+        ret = mbedtls_pk_write_key_pem(&pk, (unsigned char *)key, key_len);
+    }
+
+    mbedtls_x509write_crt_free(&crt);
+    mbedtls_pk_free(&pk);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Certificate generation failed (-0x%04x)", (unsigned)-ret);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t tls_cert_load(tls_cert_t *cert)
+{
+    cert->cert_pem = prov_malloc(CERT_PEM_MAX);
+    cert->key_pem  = prov_malloc(KEY_PEM_MAX);
+    if (!cert->cert_pem || !cert->key_pem) {
+        tls_cert_free(cert);
+        return ESP_ERR_NO_MEM;
+    }
+
+    cert->cert_len = CERT_PEM_MAX;
+    cert->key_len  = KEY_PEM_MAX;
+    if (nvs_store_load_tls(cert->cert_pem, &cert->cert_len,
+                           cert->key_pem, &cert->key_len) == ESP_OK) {
+        ESP_LOGI(TAG, "Loaded stored certificate");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Generating ECDSA P-256 certificate …");
+    int64_t t0 = esp_timer_get_time();
+
+    esp_err_t err = generate(cert->cert_pem, CERT_PEM_MAX,
+                             cert->key_pem, KEY_PEM_MAX);
+    if (err != ESP_OK) {
+        tls_cert_free(cert);
+        return err;
+    }
+    cert->cert_len = strlen(cert->cert_pem) + 1;
+    cert->key_len  = strlen(cert->key_pem) + 1;
+
+    ESP_LOGI(TAG, "Certificate generated in %d ms",
+             (int)((esp_timer_get_time() - t0) / 1000));
+
+    /* Not fatal: the certificate is still usable for this session */
+    nvs_store_save_tls(cert->cert_pem, cert->key_pem);
+    return ESP_OK;
+}
+
+void tls_cert_free(tls_cert_t *cert)
+{
+    prov_free(cert->key_pem);   /* reverse order lets the arena pop both */
+    prov_free(cert->cert_pem);
+    cert->cert_pem = NULL;
+    cert->key_pem  = NULL;
+    cert->cert_len = 0;
+    cert->key_len  = 0;
+}
@@ -11,17 +11,95 @@
 static const char *TAG = "wifi_prov_ap";
 
 static esp_netif_t *s_ap_netif = NULL;
+static bool         s_auto_channel = false;
+static char         s_target_ssid[33];
+
+/* ── Channel selection ──────────────────────────────────────────────── */
+
+/*
+ * Congestion of a channel: every AP within 4 channels (20 MHz overlap)
+ * counts, weighted by how close it is and how loud it is.
+ */
+static int channel_load(uint8_t channel, const wifi_scan_entry_t *nets, uint16_t count)
+{
+    int load = 0;
+    for (int i = 0; i < count; i++) {
+        int dist = abs((int)nets[i].channel - channel);
+        if (dist < 5) {
+            load += (5 - dist) * (nets[i].rssi + 100);
+        }
+    }
+    return load;
+}
+
+/*
+ * Auto channel: share the target network's channel so APSTA never has
+ * to hop, otherwise the least congested of the non-overlapping 1/6/11.
+ */
+static uint8_t pick_channel(void)
+{
+    if (wifi_scan_run(0) != ESP_OK) {
+        return 1;
+    }
+
+    wifi_scan_entry_t target;
+    if (s_target_ssid[0] != '\0' && wifi_scan_cache_find(s_target_ssid, &target)) {
+        ESP_LOGI(TAG, "Using channel %d of \"%s\"", target.channel, s_target_ssid);
+        return target.channel;
+    }
+
+    wifi_scan_entry_t *nets = prov_malloc(CONFIG_WIFI_PROV_SCAN_CACHE_SIZE * sizeof(*nets));
+    if (!nets) {
+        return 1;
+    }
+    uint16_t count = wifi_scan_cache_snapshot(nets, CONFIG_WIFI_PROV_SCAN_CACHE_SIZE);
+    static const uint8_t candidates[] = { 1, 6, 11 };
+    uint8_t best = candidates[0];
+    int best_load = channel_load(best, nets, count);
+
+    for (int i = 1; i < (int)sizeof(candidates); i++) {
+        int load = channel_load(candidates[i], nets, count);
+        if (load < best_load) {
+            best      = candidates[i];
+            best_load = load;
+        }
+    }
+    prov_free(nets);
+    return best;
+}
+
+void wifi_ap_set_target(const char *ssid)
+{
+    strncpy(s_target_ssid, ssid ? ssid : "", sizeof(s_target_ssid) - 1);
+}
+
+/* ── Start / Stop ───────────────────────────────────────────────────── */
 
 esp_err_t wifi_ap_start(const wifi_prov_config_t *config)
 {
     s_ap_netif = esp_netif_create_default_wifi_ap();
-    esp_netif_create_default_wifi_sta(); /* needed for scan in APSTA mode */
+    wifi_sta_netif(); /* needed for scan in APSTA mode */
+
+    uint8_t channel = config->ap_channel;
+    s_auto_channel  = channel == 0;
+
+    /* Next to a live STA link the radio is tied to that AP's channel */
+    wifi_ap_record_t uplink;
+    if (esp_wifi_sta_get_ap_info(&uplink) == ESP_OK) {
+        channel = uplink.primary;
+    } else if (s_auto_channel) {
+        /* Scan in STA mode first; the AP comes up on the chosen channel */
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+        ESP_ERROR_CHECK(esp_wifi_start());
+        channel = pick_channel();
+    }
 
     wifi_config_t wifi_config = {
         .ap = {
-            .channel        = config->ap_channel,
+            .channel        = channel,
             .max_connection = config->ap_max_connections,
             .authmode       = WIFI_AUTH_OPEN,
+            .beacon_interval = config->ap_beacon_interval,
         },
     };
 
@@ -38,21 +116,48 @@ esp_err_t wifi_ap_start(const wifi_prov_config_t *config)
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    if (config->ap_inactive_time) {
+        esp_wifi_set_inactive_time(WIFI_IF_AP, config->ap_inactive_time);
+    }
 
-    ESP_LOGI(TAG, "AP started – SSID: \"%s\", channel: %d",
-             config->ap_ssid, config->ap_channel);
+    ESP_LOGI(TAG, "AP started – SSID: \"%s\", channel: %d%s",
+             config->ap_ssid, channel, s_auto_channel ? " (auto)" : "");
     return ESP_OK;
 }
 
-esp_err_t wifi_ap_stop(void)
+/*
+ * Move the AP to the channel the STA is about to use, so the trial
+ * connect does not make the radio hop between two channels. Clients
+ * re-associate on the new channel. Fixed-channel APs are left alone.
+ */
+void wifi_ap_follow_channel(uint8_t channel)
 {
-    esp_err_t err = esp_wifi_stop();
+    wifi_config_t wifi_config;
+    if (!s_ap_netif || !s_auto_channel || channel == 0 ||
+        esp_wifi_get_config(WIFI_IF_AP, &wifi_config) != ESP_OK ||
+        wifi_config.ap.channel == channel) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Moving AP from channel %d to %d", wifi_config.ap.channel, channel);
+    wifi_config.ap.channel = channel;
+    esp_wifi_set_config(WIFI_IF_AP, &wifi_config);
+}
 
-    if (s_ap_netif) {
-        esp_netif_destroy_default_wifi(s_ap_netif);
-        s_ap_netif = NULL;
+esp_err_t wifi_ap_dispose(void)
+{
+    if (!s_ap_netif) {
+        return ESP_OK;
     }
 
+    esp_netif_dhcps_stop(s_ap_netif);
+
+    /* Drop the AP but keep the driver (and any STA link) running */
+    esp_err_t err = esp_wifi_set_mode(WIFI_MODE_STA);
+
+    esp_netif_destroy_default_wifi(s_ap_netif);
+    s_ap_netif = NULL;
+
     ESP_LOGI(TAG, "AP stopped");
     return err;
 }
@@ -13,26 +13,200 @@
 #include "esp_wifi_types.h"
 #include "esp_netif.h"
 #include "esp_log.h"
+#include "esp_event.h"
+#include "mbedtls/gcm.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+/* ── Portal memory ──────────────────────────────────────────────────── */
+
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+esp_err_t arena_init(size_t size);
+void     *arena_alloc(size_t size);
+void      arena_free(void *ptr);
+void      arena_release(void);
+
+#define prov_malloc(size) arena_alloc(size)
+#define prov_free(ptr)    arena_free(ptr)
+#else
+#define prov_malloc(size) malloc(size)
+#define prov_free(ptr)    free(ptr)
+#endif
+
+/* ── Credentials ────────────────────────────────────────────────────── */
+
+/* Also the payload of WIFI_PROV_EVENT_CREDENTIALS_SET */
+typedef struct {
+    char             ssid[33];
+    char             password[65];
+    wifi_auth_mode_t authmode;   /* as scanned, WIFI_AUTH_MAX if unknown */
+    uint8_t          bssid[6];   /* pinned AP, valid if bssid_set */
+    bool             bssid_set;
+    uint8_t          channel;    /* pinned channel, 0 = scan all */
+} wifi_prov_creds_t;
+
+/* ── Provisioning pipeline ──────────────────────────────────────────── */
+
+ESP_EVENT_DECLARE_BASE(WIFI_PROV_EVENT);
+enum { WIFI_PROV_EVENT_CREDENTIALS_SET };   /* payload: the SSID, never the password */
+
+/* A way of receiving credentials while unprovisioned */
+typedef struct {
+    const char *name;
+    esp_err_t (*start)(const wifi_prov_config_t *config);
+    esp_err_t (*stop)(void);
+} prov_transport_t;
+
+extern const prov_transport_t prov_transport_http;
+#if CONFIG_WIFI_PROV_TRANSPORT_BLE
+extern const prov_transport_t prov_transport_ble;
+#endif
+
+const prov_transport_t *provision_transport(wifi_prov_transport_t id);
+/* Serve @p id with another transport; takes effect at the next start */
+esp_err_t provision_register_transport(wifi_prov_transport_t id,
+                                       const prov_transport_t *transport);
+esp_err_t provision_apply(wifi_prov_creds_t *creds);
+void      provision_complete(const wifi_prov_creds_t *creds);
+
+/* ── Event log (CONFIG_WIFI_PROV_STATS) ─────────────────────────────── */
+
+/* Meaning of the a / b payload per event */
+typedef enum {
+    STATS_DNS_QUERY,        /* a: answer length,  b: -                  */
+    STATS_HTTP_REQUEST,     /* a: route id,       b: latency (ms)       */
+    STATS_SCAN,             /* a: networks found, b: duration (ms)      */
+    STATS_STA_CONNECT,      /* a: 1 = connected,  b: duration (ms)      */
+    STATS_STA_DISCONNECT,   /* a: reason code,    b: -                  */
+    STATS_NVS_LOAD,         /* a: esp_err_t & 0xffff, b: duration (µs)  */
+    STATS_NVS_SAVE,         /* a: esp_err_t & 0xffff, b: duration (µs)  */
+    STATS_ROAM,             /* a: 1 = link dropped, b: duration (ms)    */
+    STATS_EVENT_MAX,
+} stats_event_t;
+
+#if CONFIG_WIFI_PROV_STATS
+void   stats_record(stats_event_t type, uint16_t a, uint32_t b);
+size_t stats_dump(char *buf, size_t len);
+#else
+static inline void stats_record(stats_event_t type, uint16_t a, uint32_t b) {}
+#endif
+
 /* ── NVS store ──────────────────────────────────────────────────────── */
 
-esp_err_t nvs_store_load(char *ssid, size_t ssid_len,
-                         char *password, size_t pass_len);
-esp_err_t nvs_store_save(const char *ssid, const char *password);
+esp_err_t nvs_store_load(wifi_prov_creds_t *creds);
+esp_err_t nvs_store_save(const wifi_prov_creds_t *creds);
 esp_err_t nvs_store_erase(void);
+esp_err_t nvs_store_load_pmk(const char *ssid, char *psk, size_t psk_len);
+void      nvs_store_set_key_provider(wifi_prov_key_provider_t provider);
+esp_err_t nvs_store_load_tls(char *cert, size_t *cert_len,
+                             char *key, size_t *key_len);
+esp_err_t nvs_store_save_tls(const char *cert, const char *key);
+
+/* ── Crypto ─────────────────────────────────────────────────────────── */
+
+#define CRYPTO_KEY_LEN  32
+#define CRYPTO_OVERHEAD (1 + 12 + 16) /* version + nonce + tag */
+
+typedef struct {
+    mbedtls_gcm_context gcm;
+    bool                ready;
+} crypto_key_t;
+
+esp_err_t crypto_key_init(crypto_key_t *key, const uint8_t material[CRYPTO_KEY_LEN]);
+void      crypto_key_free(crypto_key_t *key);
+esp_err_t crypto_seal(crypto_key_t *key, const void *plain, size_t len,
+                      const void *aad, size_t aad_len,
+                      uint8_t *out, size_t *out_len);
+esp_err_t crypto_open(crypto_key_t *key, const uint8_t *blob, size_t blob_len,
+                      const void *aad, size_t aad_len,
+                      void *plain, size_t *len);
+esp_err_t crypto_efuse_key(uint8_t material[CRYPTO_KEY_LEN]);
+
+#define WIFI_PMK_LEN 32
+
+esp_err_t crypto_wpa_pmk(const char *ssid, const char *passphrase,
+                         uint8_t pmk[WIFI_PMK_LEN]);
+
+/*
+ * Networks that take the PMK as a raw PSK: WPA/WPA2-Personal only. SAE
+ * (WPA3 and the WPA2/WPA3 transition mode) needs the passphrase, and an
+ * unknown auth mode (WIFI_AUTH_MAX, network not scanned) may be either.
+ */
+static inline bool crypto_pmk_usable(wifi_auth_mode_t authmode)
+{
+    return authmode == WIFI_AUTH_WPA_PSK || authmode == WIFI_AUTH_WPA2_PSK ||
+           authmode == WIFI_AUTH_WPA_WPA2_PSK;
+}
 
 /* ── WiFi STA ───────────────────────────────────────────────────────── */
 
-esp_err_t wifi_sta_connect(const char *ssid, const char *password,
-                           uint8_t max_retries);
-esp_err_t wifi_sta_try_connect(const char *ssid, const char *password);
+void      wifi_sta_set_policy(const wifi_prov_config_t *config);
+esp_err_t wifi_sta_connect(const wifi_prov_creds_t *creds, uint8_t max_retries);
+esp_err_t wifi_sta_try_connect(const wifi_prov_creds_t *creds);
+esp_netif_t *wifi_sta_netif(void);
+
+/* ── Roaming (CONFIG_WIFI_PROV_ROAMING) ─────────────────────────────── */
+
+#if CONFIG_WIFI_PROV_ROAMING
+esp_err_t roam_start(void);
+void      roam_stop(void);
+#else
+static inline esp_err_t roam_start(void) { return ESP_OK; }
+static inline void roam_stop(void) {}
+#endif
+
+/* ── WiFi scan ──────────────────────────────────────────────────────── */
+
+typedef wifi_prov_network_t wifi_scan_entry_t;
+
+esp_err_t wifi_scan_async(const wifi_prov_scan_filter_t *filter,
+                          wifi_prov_scan_cb_t cb, void *arg);
+esp_err_t wifi_scan_run(uint32_t max_age_ms);
+void      wifi_scan_reset(void);
+uint16_t  wifi_scan_cache_snapshot(wifi_scan_entry_t *out, uint16_t max);
+bool      wifi_scan_cache_find(const char *ssid, wifi_scan_entry_t *entry);
+bool      wifi_scan_cache_find_bssid(const uint8_t bssid[6], wifi_scan_entry_t *entry);
+
+/* ── ESP-NOW credential sharing (CONFIG_WIFI_PROV_ESPNOW) ───────────── */
+
+esp_err_t espnow_share_send(uint32_t duration_ms);
+esp_err_t espnow_share_receive(uint8_t first_channel, uint32_t listen_ms,
+                               wifi_prov_creds_t *creds);
 
 /* ── WiFi AP ────────────────────────────────────────────────────────── */
 
+void      wifi_ap_set_target(const char *ssid);
 esp_err_t wifi_ap_start(const wifi_prov_config_t *config);
-esp_err_t wifi_ap_stop(void);
+void      wifi_ap_follow_channel(uint8_t channel);
+esp_err_t wifi_ap_dispose(void);
+
+/* ── Portal pages (generated by tools/gen_portal.py) ────────────────── */
+
+typedef struct {
+    const char    *lang;    /* two-letter language code */
+    const uint8_t *gz;      /* gzip-compressed page */
+    size_t         gz_len;
+    const uint8_t *plain;   /* the same page uncompressed */
+    size_t         plain_len;
+} portal_asset_t;
+
+extern const portal_asset_t portal_assets[];   /* [0] is the default */
+extern const size_t         portal_asset_count;
+/* (c1 - 'a') * 26 + (c2 - 'a') -> index into portal_assets + 1, 0 = none */
+extern const uint8_t        portal_locale_index[26 * 26];
+
+/* ── Portal codecs ──────────────────────────────────────────────────── */
+
+int    hex_val(char c);
+void   url_decode(char *dst, size_t dst_len, const char *src, size_t src_len);
+bool   form_field(const char *body, const char *name, char *dst, size_t dst_len);
+bool   parse_bssid(const char *str, uint8_t bssid[6]);
+size_t json_networks_max(uint16_t count);
+size_t json_networks(char *buf, const wifi_scan_entry_t *nets, uint16_t count);
+size_t json_branding(char *buf, const wifi_prov_config_t *cfg);
+uint32_t fnv1a(const void *data, size_t len);
+size_t dns_build_response(uint8_t *buf, size_t len, size_t cap, uint32_t ip);
 
 /* ── DNS server ─────────────────────────────────────────────────────── */
 
@@ -43,3 +217,17 @@ esp_err_t dns_server_stop(void);
 
 esp_err_t http_server_start(uint16_t port, const wifi_prov_config_t *config);
 esp_err_t http_server_stop(void);
+esp_err_t http_server_update_branding(const wifi_prov_config_t *config);
+
+/* ── TLS certificate (CONFIG_WIFI_PROV_HTTPS) ───────────────────────── */
+
+/* PEM buffers; lengths include the NUL terminator as esp_https_server expects */
+typedef struct {
+    char  *cert_pem;
+    size_t cert_len;
+    char  *key_pem;
+    size_t key_len;
+} tls_cert_t;
+
+esp_err_t tls_cert_load(tls_cert_t *cert);
+void      tls_cert_free(tls_cert_t *cert);
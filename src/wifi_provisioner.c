@@ -8,6 +8,8 @@
 #include "wifi_prov_internal.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "freertos/event_groups.h"
 
@@ -18,17 +20,107 @@ static const char *TAG = "wifi_prov";
 static wifi_prov_config_t s_config;
 static esp_netif_t       *s_sta_netif = NULL;
 static EventGroupHandle_t s_connected_event;
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+static StaticEventGroup_t s_connected_event_buf;
+#endif
 static bool               s_connected = false;
 static bool               s_initialized = false;
+static bool               s_started = false;
+static bool               s_portal_active = false;
+static const prov_transport_t *s_transport = NULL;
+static uint32_t           s_heap_before_portal;
+static wifi_prov_branding_t s_branding;        /* set before start, applied on it */
+static bool               s_branding_set = false;
 
-/* Event base declared/defined in http_server.c */
-ESP_EVENT_DECLARE_BASE(WIFI_PROV_EVENT);
-enum { WIFI_PROV_EVENT_CREDENTIALS_SET };
+/* ── Radio state ────────────────────────────────────────────────────── */
 
-typedef struct {
-    char ssid[33];
-    char password[65];
-} wifi_prov_creds_t;
+static wifi_prov_radio_state_t s_radio_state = WIFI_PROV_RADIO_OFF;
+static int64_t                 s_radio_since;  /* µs */
+static uint64_t                s_radio_ms[WIFI_PROV_RADIO_STATE_MAX];
+static portMUX_TYPE            s_radio_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void radio_state_set(wifi_prov_radio_state_t state)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_radio_lock);
+    s_radio_ms[s_radio_state] += (uint64_t)(now - s_radio_since) / 1000;
+    s_radio_state = state;
+    s_radio_since = now;
+    portEXIT_CRITICAL(&s_radio_lock);
+}
+
+/* Wi-Fi/Bluetooth coexistence needs modem sleep; the driver refuses PS_NONE */
+static bool radio_bt_in_use(void)
+{
+#if CONFIG_BT_ENABLED
+    return true;
+#else
+    return s_config.transport == WIFI_PROV_TRANSPORT_BLE;
+#endif
+}
+
+/* Apply a power save mode and return the one actually in effect */
+static wifi_ps_type_t radio_set_ps(wifi_ps_type_t ps)
+{
+    if (ps == WIFI_PS_NONE && radio_bt_in_use()) {
+        ps = WIFI_PS_MIN_MODEM;
+    }
+
+    esp_err_t err = esp_wifi_set_ps(ps);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Power save mode %d not applied: %s", ps, esp_err_to_name(err));
+        if (esp_wifi_get_ps(&ps) != ESP_OK) {
+            ps = WIFI_PS_MIN_MODEM; /* driver default */
+        }
+    }
+    return ps;
+}
+
+/* Connected and the portal gone: apply the configured power save, roam */
+static void radio_connected(void)
+{
+    wifi_ps_type_t ps = radio_set_ps(s_config.sta_ps_mode);
+    roam_start();
+    radio_state_set(ps == WIFI_PS_NONE ? WIFI_PROV_RADIO_ACTIVE
+                                       : WIFI_PROV_RADIO_POWER_SAVE);
+}
+
+/*
+ * The portal keeps the radio awake so clients and trial connects are
+ * prompt, or as close to it as Bluetooth coexistence allows
+ */
+static void radio_portal(void)
+{
+    roam_stop(); /* trial connects drive the STA now */
+    radio_set_ps(WIFI_PS_NONE);
+    radio_state_set(WIFI_PROV_RADIO_PORTAL);
+}
+
+/* ── Portal teardown ────────────────────────────────────────────────── */
+
+/*
+ * Release everything the portal owns: the transport (for the captive
+ * portal: HTTP server, DNS task, AP netif and DHCP server) and the
+ * arena. Leaves the driver in STA mode. The portal page itself lives
+ * in flash and holds no RAM.
+ */
+static void portal_dispose(void)
+{
+    if (!s_portal_active) {
+        return;
+    }
+
+    s_transport->stop();
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    arena_release();
+#endif
+
+    s_portal_active = false;
+
+    uint32_t heap = esp_get_free_heap_size();
+    ESP_LOGI(TAG, "Portal disposed, free heap %u bytes (%+d vs. before portal)",
+             (unsigned)heap, (int)(heap - s_heap_before_portal));
+}
 
 /* ── Portal credential callback ─────────────────────────────────────── */
 
@@ -37,15 +129,12 @@ static void on_credentials_set(void *arg, esp_event_base_t base,
 {
     ESP_LOGI(TAG, "STA connected via portal, tearing down AP …");
 
-    /* Tear down portal services */
-    http_server_stop();
-    dns_server_stop();
-
-    /* Switch from APSTA to STA-only (drops the AP, keeps STA connected) */
-    esp_wifi_set_mode(WIFI_MODE_STA);
+    /* Drops the AP and portal services, keeps the STA connected */
+    portal_dispose();
 
-    /* Get a reference to the STA netif (created by wifi_ap_start in APSTA mode) */
+    /* Get a reference to the STA netif (created by the transport) */
     s_sta_netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    radio_connected();
 
     s_connected = true;
     xEventGroupSetBits(s_connected_event, CONNECTED_BIT);
@@ -54,6 +143,18 @@ static void on_credentials_set(void *arg, esp_event_base_t base,
     }
 }
 
+/* ── Branding ───────────────────────────────────────────────────────── */
+
+static void branding_apply(const wifi_prov_branding_t *branding)
+{
+    s_config.page_title          = branding->page_title;
+    s_config.portal_header       = branding->portal_header;
+    s_config.portal_subheader    = branding->portal_subheader;
+    s_config.connected_header    = branding->connected_header;
+    s_config.connected_subheader = branding->connected_subheader;
+    s_config.page_footer         = branding->page_footer;
+}
+
 /* ── Public API ─────────────────────────────────────────────────────── */
 
 esp_err_t wifi_prov_init(void)
@@ -76,34 +177,94 @@ esp_err_t wifi_prov_init(void)
     return ESP_OK;
 }
 
+/*
+ * Start and stop pair up exactly: everything start creates (event group,
+ * handler, driver, netifs, portal) is released by stop, and a repeated
+ * start or stop is a no-op, so provisioning can be toggled at will.
+ */
 esp_err_t wifi_prov_start(const wifi_prov_config_t *config)
 {
     ESP_ERROR_CHECK(wifi_prov_init());
 
-    s_config = *config;
+    if (s_started) {
+        return ESP_OK;
+    }
+
+    s_transport = provision_transport(config->transport);
+    if (!s_transport) {
+        ESP_LOGE(TAG, "Provisioning transport %d not enabled", config->transport);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_config    = *config;
     s_connected = false;
+    s_started   = true;
+    if (s_branding_set) {
+        branding_apply(&s_branding);
+    }
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    s_connected_event = xEventGroupCreateStatic(&s_connected_event_buf);
+#else
     s_connected_event = xEventGroupCreate();
+#endif
 
     /* Register for portal credential events */
     ESP_ERROR_CHECK(esp_event_handler_register(
         WIFI_PROV_EVENT, WIFI_PROV_EVENT_CREDENTIALS_SET,
         on_credentials_set, NULL));
 
+    wifi_sta_set_policy(&s_config);
+
     /* Try loading stored credentials */
-    char ssid[33]     = {0};
-    char password[65] = {0};
-    esp_err_t err = nvs_store_load(ssid, sizeof(ssid),
-                                   password, sizeof(password));
+    wifi_prov_creds_t creds = {0};
+    esp_err_t err = nvs_store_load(&creds);
+    bool shared = false;
+
+#if CONFIG_WIFI_PROV_ESPNOW
+    /* Unprovisioned: give a sharing peer a chance before the portal */
+    if (err != ESP_OK || creds.ssid[0] == '\0') {
+        wifi_init_config_t wifi_init = WIFI_INIT_CONFIG_DEFAULT();
+        ESP_ERROR_CHECK(esp_wifi_init(&wifi_init));
+        radio_state_set(WIFI_PROV_RADIO_SEARCHING);
+        shared = espnow_share_receive(s_config.ap_channel,
+                                      CONFIG_WIFI_PROV_ESPNOW_LISTEN_MS,
+                                      &creds) == ESP_OK;
+        esp_wifi_deinit();
+        err = shared ? ESP_OK : err;
+    }
+#endif
 
-    if (err == ESP_OK && ssid[0] != '\0') {
-        ESP_LOGI(TAG, "Found stored credentials, attempting STA connection …");
+    if (err == ESP_OK && creds.ssid[0] != '\0') {
+        ESP_LOGI(TAG, "Found %s credentials, attempting STA connection …",
+                 shared ? "shared" : "stored");
 
-        s_sta_netif = esp_netif_create_default_wifi_sta();
+        s_sta_netif = wifi_sta_netif();
         wifi_init_config_t wifi_init = WIFI_INIT_CONFIG_DEFAULT();
         ESP_ERROR_CHECK(esp_wifi_init(&wifi_init));
 
-        err = wifi_sta_connect(ssid, password, s_config.max_retries);
+        /*
+         * Prefer the precomputed PMK so the supplicant skips PBKDF2.
+         * SAE needs the passphrase, so WPA3, transition and networks of
+         * unknown auth mode keep using it.
+         */
+        char psk[65];
+        if (crypto_pmk_usable(creds.authmode) &&
+            nvs_store_load_pmk(creds.ssid, psk, sizeof(psk)) == ESP_OK) {
+            memcpy(creds.password, psk, sizeof(creds.password));
+        }
+        memset(psk, 0, sizeof(psk));
+
+        radio_state_set(WIFI_PROV_RADIO_SEARCHING);
+        err = wifi_sta_connect(&creds, s_config.max_retries);
+        if (err == ESP_OK && shared) {
+            /* Only persist a shared record once it has proven to work */
+            nvs_store_save(&creds);
+        }
+        /* An auto-channel AP starts on this network's channel if in range */
+        wifi_ap_set_target(err == ESP_OK ? NULL : creds.ssid);
+        memset(&creds, 0, sizeof(creds));
         if (err == ESP_OK) {
+            radio_connected();
             s_connected = true;
             xEventGroupSetBits(s_connected_event, CONNECTED_BIT);
             if (s_config.on_connected) {
@@ -122,13 +283,27 @@ esp_err_t wifi_prov_start(const wifi_prov_config_t *config)
         ESP_LOGI(TAG, "No stored credentials, starting provisioning portal");
     }
 
-    /* Start AP + captive portal */
+    /* Start the provisioning transport (by default AP + captive portal) */
     wifi_init_config_t wifi_init = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&wifi_init));
 
-    wifi_ap_start(&s_config);
-    dns_server_start();
-    http_server_start(s_config.http_port, &s_config);
+    s_heap_before_portal = esp_get_free_heap_size();
+    s_portal_active      = true;
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    err = arena_init(CONFIG_WIFI_PROV_ARENA_SIZE);
+    if (err == ESP_OK) {
+        err = s_transport->start(&s_config);
+    }
+#else
+    err = s_transport->start(&s_config);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start %s (%s)", s_transport->name,
+                 esp_err_to_name(err));
+        wifi_prov_stop();
+        return err;
+    }
+    radio_portal();
 
     if (s_config.on_portal_start) {
         s_config.on_portal_start();
@@ -139,16 +314,23 @@ esp_err_t wifi_prov_start(const wifi_prov_config_t *config)
 
 esp_err_t wifi_prov_stop(void)
 {
-    http_server_stop();
-    dns_server_stop();
-    wifi_ap_stop();
+    if (!s_started) {
+        return ESP_OK;
+    }
+
+    roam_stop();
+    portal_dispose();
+    wifi_ap_set_target(NULL);   /* a later start may have other credentials */
+    wifi_scan_reset();
     esp_wifi_stop();
     esp_wifi_deinit();
 
-    if (s_sta_netif) {
-        esp_netif_destroy_default_wifi(s_sta_netif);
-        s_sta_netif = NULL;
+    /* Whoever created it (boot path, AP or BLE transport), it is ours */
+    esp_netif_t *sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (sta) {
+        esp_netif_destroy_default_wifi(sta);
     }
+    s_sta_netif = NULL;
 
     if (s_connected_event) {
         vEventGroupDelete(s_connected_event);
@@ -160,6 +342,8 @@ esp_err_t wifi_prov_stop(void)
                                  on_credentials_set);
 
     s_connected = false;
+    s_started   = false;
+    radio_state_set(WIFI_PROV_RADIO_OFF);
     return ESP_OK;
 }
 
@@ -168,6 +352,9 @@ esp_err_t wifi_prov_wait_for_connection(TickType_t timeout_ticks)
     if (s_connected) {
         return ESP_OK;
     }
+    if (!s_connected_event) {
+        return ESP_ERR_INVALID_STATE; /* not started */
+    }
 
     EventBits_t bits = xEventGroupWaitBits(s_connected_event,
         CONNECTED_BIT, pdFALSE, pdTRUE, timeout_ticks);
@@ -175,12 +362,125 @@ esp_err_t wifi_prov_wait_for_connection(TickType_t timeout_ticks)
     return (bits & CONNECTED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
 }
 
+esp_err_t wifi_prov_open_portal(void)
+{
+    if (s_portal_active) {
+        return ESP_OK;
+    }
+    if (!s_connected || !s_transport) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "Opening %s next to the STA link …", s_transport->name);
+
+    /* Same netifs and driver; the transport only adds the AP side */
+    wifi_ap_set_target(NULL);
+    s_heap_before_portal = esp_get_free_heap_size();
+    s_portal_active      = true;
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    esp_err_t err = arena_init(CONFIG_WIFI_PROV_ARENA_SIZE);
+    if (err == ESP_OK) {
+        err = s_transport->start(&s_config);
+    }
+#else
+    esp_err_t err = s_transport->start(&s_config);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start %s (%s)", s_transport->name,
+                 esp_err_to_name(err));
+        portal_dispose();
+        return err;
+    }
+    radio_portal();
+
+    if (s_config.on_portal_start) {
+        s_config.on_portal_start();
+    }
+    return ESP_OK;
+}
+
+esp_err_t wifi_prov_close_portal(void)
+{
+    if (s_portal_active) {
+        portal_dispose();
+        radio_connected();
+    }
+    return ESP_OK;
+}
+
 esp_err_t wifi_prov_erase_credentials(void)
 {
     ESP_ERROR_CHECK(wifi_prov_init());
     return nvs_store_erase();
 }
 
+esp_err_t wifi_prov_set_key_provider(wifi_prov_key_provider_t provider)
+{
+    nvs_store_set_key_provider(provider);
+    return ESP_OK;
+}
+
+esp_err_t wifi_prov_share_credentials(uint32_t duration_ms)
+{
+#if CONFIG_WIFI_PROV_ESPNOW
+    if (!s_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return espnow_share_send(duration_ms);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t wifi_prov_set_branding(const wifi_prov_branding_t *branding)
+{
+    if (!branding) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Kept apart from s_config, which the next start overwrites */
+    s_branding     = *branding;
+    s_branding_set = true;
+    if (!s_started) {
+        return ESP_OK;
+    }
+    branding_apply(&s_branding);
+    return http_server_update_branding(&s_config);
+}
+
+esp_err_t wifi_prov_scan_async(const wifi_prov_scan_filter_t *filter,
+                               wifi_prov_scan_cb_t cb, void *arg)
+{
+    if (!cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return wifi_scan_async(filter, cb, arg);
+}
+
+size_t wifi_prov_dump_events(char *buf, size_t len)
+{
+#if CONFIG_WIFI_PROV_STATS
+    return stats_dump(buf, len);
+#else
+    return 0;
+#endif
+}
+
+esp_err_t wifi_prov_get_radio_stats(wifi_prov_radio_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_radio_lock);
+    memcpy(stats->time_ms, s_radio_ms, sizeof(stats->time_ms));
+    stats->state = s_radio_state;
+    stats->time_ms[s_radio_state] += (uint64_t)(now - s_radio_since) / 1000;
+    portEXIT_CRITICAL(&s_radio_lock);
+    return ESP_OK;
+}
+
 bool wifi_prov_is_connected(void)
 {
     return s_connected;
@@ -0,0 +1,419 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Network scan and the cache of its results: one entry per SSID, and
+ * one per BSSID for hidden networks, which have no SSID to group by.
+ *
+ * Scans are event driven: requests queue up as waiters, and everyone
+ * waiting when the radio finishes is served from the same result, so
+ * the portal and the application never scan twice in a row.
+ *
+ * The cache is read from the HTTP server, the event loop and the
+ * application, so it is only ever copied in or out under the lock.
+ */
+
+#include "wifi_prov_internal.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define CACHE_SIZE   CONFIG_WIFI_PROV_SCAN_CACHE_SIZE
+#define MAX_WAITERS  4
+
+typedef struct {
+    wifi_prov_scan_filter_t filter;
+    char                    prefix[33];
+    wifi_prov_scan_cb_t     cb;
+    void                   *arg;
+} scan_waiter_t;
+
+static const char *TAG = "wifi_prov_scan";
+
+static wifi_scan_entry_t s_cache[CACHE_SIZE];
+static uint16_t          s_cache_count;
+static int64_t           s_cache_time = -1;   /* µs, -1 = never scanned */
+static int64_t           s_scan_start;
+
+static scan_waiter_t     s_waiters[MAX_WAITERS];
+static uint8_t           s_waiter_count;
+static bool              s_scanning = false;
+static portMUX_TYPE      s_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_event_handler_instance_t s_done_handler;
+
+/* ── Cache ──────────────────────────────────────────────────────────── */
+
+static bool same_network(const wifi_scan_entry_t *e, const wifi_ap_record_t *rec)
+{
+    const char *ssid = (const char *)rec->ssid;
+    if (ssid[0] == '\0') {
+        return e->ssid[0] == '\0' && memcmp(e->bssid, rec->bssid, sizeof(e->bssid)) == 0;
+    }
+    return strcmp(e->ssid, ssid) == 0;
+}
+
+/*
+ * Keep the strongest AP per network. When the cache is full a new
+ * network only gets in by evicting the weakest entry.
+ */
+static void cache_insert(wifi_scan_entry_t *cache, uint16_t *count,
+                         const wifi_ap_record_t *rec)
+{
+    const char *ssid = (const char *)rec->ssid;
+    wifi_scan_entry_t *e = NULL;
+
+    for (int i = 0; i < *count; i++) {
+        if (same_network(&cache[i], rec)) {
+            if (rec->rssi <= cache[i].rssi) {
+                return;
+            }
+            e = &cache[i];
+            break;
+        }
+    }
+
+    if (!e) {
+        if (*count < CACHE_SIZE) {
+            e = &cache[(*count)++];
+        } else {
+            e = &cache[0];
+            for (int i = 1; i < *count; i++) {
+                if (cache[i].rssi < e->rssi) {
+                    e = &cache[i];
+                }
+            }
+            if (rec->rssi <= e->rssi) {
+                return;
+            }
+        }
+    }
+
+    strncpy(e->ssid, ssid, sizeof(e->ssid) - 1);
+    e->ssid[sizeof(e->ssid) - 1] = '\0';
+    memcpy(e->bssid, rec->bssid, sizeof(e->bssid));
+    e->channel  = rec->primary;
+    e->rssi     = rec->rssi;
+    e->authmode = rec->authmode;
+}
+
+static int by_rssi_desc(const void *a, const void *b)
+{
+    return ((const wifi_scan_entry_t *)b)->rssi - ((const wifi_scan_entry_t *)a)->rssi;
+}
+
+/*
+ * Drain the driver's AP list into the cache, strongest first. The list
+ * is built aside and swapped in, so readers never see half a scan.
+ */
+static esp_err_t cache_fill(void)
+{
+    uint16_t ap_count = 0;
+    esp_wifi_scan_get_ap_num(&ap_count);
+
+    wifi_scan_entry_t *fill = prov_malloc(CACHE_SIZE * sizeof(*fill));
+    if (!fill) {
+        esp_wifi_clear_ap_list();
+        return ESP_ERR_NO_MEM;
+    }
+    uint16_t count = 0;
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    /* One record at a time: the full record array is never allocated */
+    wifi_ap_record_t rec;
+    for (uint16_t i = 0; i < ap_count; i++) {
+        if (esp_wifi_scan_get_ap_record(&rec) != ESP_OK) {
+            break;
+        }
+        cache_insert(fill, &count, &rec);
+    }
+    esp_wifi_clear_ap_list();
+#else
+    if (ap_count > 0) {
+        wifi_ap_record_t *ap_records = prov_malloc(sizeof(wifi_ap_record_t) * ap_count);
+        if (!ap_records) {
+            esp_wifi_clear_ap_list();
+            prov_free(fill);
+            return ESP_ERR_NO_MEM;
+        }
+        esp_wifi_scan_get_ap_records(&ap_count, ap_records);
+
+        for (int i = 0; i < ap_count; i++) {
+            cache_insert(fill, &count, &ap_records[i]);
+        }
+        prov_free(ap_records);
+    }
+#endif
+
+    qsort(fill, count, sizeof(fill[0]), by_rssi_desc);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_cache, fill, count * sizeof(s_cache[0]));
+    s_cache_count = count;
+    s_cache_time  = now;
+    portEXIT_CRITICAL(&s_lock);
+    prov_free(fill);
+
+    ESP_LOGD(TAG, "Scan found %d APs, %d networks", ap_count, count);
+    return ESP_OK;
+}
+
+/* ── Waiters ────────────────────────────────────────────────────────── */
+
+static bool matches(const scan_waiter_t *w, const wifi_scan_entry_t *e)
+{
+    return (e->ssid[0] != '\0' || w->filter.show_hidden) &&
+           e->rssi >= w->filter.min_rssi &&
+           e->authmode >= w->filter.min_authmode &&
+           strncmp(e->ssid, w->prefix, strlen(w->prefix)) == 0;
+}
+
+/* Hand a waiter the first max_results cache entries that pass its filter */
+static void deliver(const scan_waiter_t *w, esp_err_t status)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint16_t cached = s_cache_count;
+    portEXIT_CRITICAL(&s_lock);
+
+    /* A scan may land in between; the copy below stays within limit */
+    uint16_t limit = w->filter.max_results;
+    if (limit == 0 || limit > cached) {
+        limit = cached;
+    }
+
+    wifi_scan_entry_t *out = NULL;
+    uint16_t count = 0;
+
+    if (status == ESP_OK && limit > 0) {
+        out = prov_malloc(limit * sizeof(*out));
+        if (!out) {
+            status = ESP_ERR_NO_MEM;
+        }
+    }
+    if (out) {
+        portENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < s_cache_count && count < limit; i++) {
+            if (matches(w, &s_cache[i])) {
+                out[count++] = s_cache[i];
+            }
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    w->cb(status, out, count, w->arg);
+    prov_free(out);
+}
+
+static void on_scan_done(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    const wifi_event_sta_scan_done_t *done = data;
+    esp_err_t status = (done && done->status != 0) ? ESP_FAIL : cache_fill();
+    stats_record(STATS_SCAN, s_cache_count,
+                 (uint32_t)((esp_timer_get_time() - s_scan_start) / 1000));
+
+    /*
+     * Off the event before the next scan may start: once s_scanning is
+     * clear, wifi_scan_async() registers a new instance into
+     * s_done_handler, which must not be the one removed here.
+     */
+    esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, s_done_handler);
+
+    scan_waiter_t waiters[MAX_WAITERS];
+    portENTER_CRITICAL(&s_lock);
+    uint8_t n = s_waiter_count;
+    memcpy(waiters, s_waiters, n * sizeof(waiters[0]));
+    s_waiter_count = 0;
+    s_scanning     = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < n; i++) {
+        deliver(&waiters[i], status);
+    }
+}
+
+esp_err_t wifi_scan_async(const wifi_prov_scan_filter_t *filter,
+                          wifi_prov_scan_cb_t cb, void *arg)
+{
+    scan_waiter_t w = {
+        .filter = filter ? *filter : (wifi_prov_scan_filter_t)WIFI_PROV_SCAN_FILTER_DEFAULT(),
+        .cb     = cb,
+        .arg    = arg,
+    };
+    if (w.filter.ssid_prefix) {
+        strncpy(w.prefix, w.filter.ssid_prefix, sizeof(w.prefix) - 1);
+    }
+    w.filter.ssid_prefix = NULL; /* caller's string need not outlive the call */
+
+    /* Recent enough: answer from the cache without touching the radio */
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    bool fresh = w.filter.max_age_ms > 0 && s_cache_time >= 0 && !s_scanning &&
+                 now - s_cache_time < (int64_t)w.filter.max_age_ms * 1000;
+    portEXIT_CRITICAL(&s_lock);
+    if (fresh) {
+        deliver(&w, ESP_OK);
+        return ESP_OK;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool full  = s_waiter_count == MAX_WAITERS;
+    bool start = !s_scanning && !full;
+    if (!full) {
+        s_waiters[s_waiter_count++] = w;
+        s_scanning = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (full) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!start) {
+        return ESP_OK; /* joins the scan already in flight */
+    }
+
+    esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                        on_scan_done, NULL, &s_done_handler);
+
+    wifi_scan_config_t scan_cfg = {
+        .show_hidden = true, /* cached per BSSID, filtered per waiter */
+    };
+    s_scan_start = esp_timer_get_time();
+    esp_err_t err = esp_wifi_scan_start(&scan_cfg, false);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Scan failed (%s)", esp_err_to_name(err));
+        esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                              s_done_handler);
+
+        scan_waiter_t waiters[MAX_WAITERS];
+        portENTER_CRITICAL(&s_lock);
+        uint8_t n = s_waiter_count;
+        memcpy(waiters, s_waiters, n * sizeof(waiters[0]));
+        s_waiter_count = 0;
+        s_scanning     = false;
+        portEXIT_CRITICAL(&s_lock);
+
+        /* Waiters[0] is this caller, told by the return value */
+        for (int i = 1; i < n; i++) {
+            deliver(&waiters[i], err);
+        }
+    }
+    return err;
+}
+
+/*
+ * The driver is going away: fail whoever still waits and forget the
+ * results, so a later start neither joins a scan that never finishes
+ * nor serves networks from before.
+ */
+void wifi_scan_reset(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool scanning = s_scanning;
+    portEXIT_CRITICAL(&s_lock);
+
+    /* As in on_scan_done(): unregister while s_scanning still holds */
+    if (scanning) {
+        esp_wifi_scan_stop();
+        esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                              s_done_handler);
+    }
+
+    scan_waiter_t waiters[MAX_WAITERS];
+    portENTER_CRITICAL(&s_lock);
+    uint8_t n = s_waiter_count;
+    memcpy(waiters, s_waiters, n * sizeof(waiters[0]));
+    s_waiter_count = 0;
+    s_scanning     = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < n; i++) {
+        deliver(&waiters[i], ESP_ERR_INVALID_STATE);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_cache_count = 0;
+    s_cache_time  = -1;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/* ── Blocking wrapper ───────────────────────────────────────────────── */
+
+typedef struct {
+    SemaphoreHandle_t done;
+    esp_err_t         status;
+} sync_scan_t;
+
+static void on_sync_done(esp_err_t status, const wifi_prov_network_t *networks,
+                         uint16_t count, void *arg)
+{
+    sync_scan_t *sync = arg;
+    sync->status = status;
+    xSemaphoreGive(sync->done);
+}
+
+/* Must not be called from the default event loop task */
+esp_err_t wifi_scan_run(uint32_t max_age_ms)
+{
+    StaticSemaphore_t sem_buf;
+    sync_scan_t sync = {
+        .done   = xSemaphoreCreateBinaryStatic(&sem_buf),
+        .status = ESP_FAIL,
+    };
+
+    /* Only the completion matters here: callers read the cache */
+    wifi_prov_scan_filter_t filter = WIFI_PROV_SCAN_FILTER_DEFAULT();
+    filter.max_results = 1;
+    filter.max_age_ms  = max_age_ms;
+
+    esp_err_t err = wifi_scan_async(&filter, on_sync_done, &sync);
+    if (err == ESP_OK) {
+        xSemaphoreTake(sync.done, portMAX_DELAY);
+        err = sync.status;
+    }
+    vSemaphoreDelete(sync.done);
+    return err;
+}
+
+/* Copy up to @p max cached networks, strongest first */
+uint16_t wifi_scan_cache_snapshot(wifi_scan_entry_t *out, uint16_t max)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint16_t count = s_cache_count < max ? s_cache_count : max;
+    memcpy(out, s_cache, count * sizeof(out[0]));
+    portEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+bool wifi_scan_cache_find(const char *ssid, wifi_scan_entry_t *entry)
+{
+    if (ssid[0] == '\0') {
+        return false;
+    }
+    bool found = false;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_cache_count && !found; i++) {
+        if (strcmp(s_cache[i].ssid, ssid) == 0) {
+            *entry = s_cache[i];
+            found  = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return found;
+}
+
+/* Any cached AP with this BSSID, hidden or not */
+bool wifi_scan_cache_find_bssid(const uint8_t bssid[6], wifi_scan_entry_t *entry)
+{
+    bool found = false;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_cache_count && !found; i++) {
+        if (memcmp(s_cache[i].bssid, bssid, sizeof(s_cache[i].bssid)) == 0) {
+            *entry = s_cache[i];
+            found  = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return found;
+}
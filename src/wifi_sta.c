@@ -8,22 +8,36 @@
 #include "wifi_prov_internal.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_timer.h"
 #include "freertos/event_groups.h"
 
 #define STA_CONNECTED_BIT BIT0
 #define STA_FAILED_BIT    BIT1
 
+/* Longest a trial from the portal may take the uplink down */
+#define TRIAL_TIMEOUT_MS  15000
+
 static const char *TAG = "wifi_prov_sta";
 
 static EventGroupHandle_t s_event_group;
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+static StaticEventGroup_t s_event_group_buf;
+#endif
 static uint8_t s_retries;
 static uint8_t s_max_retries;
+static bool    s_leaving;       /* next disconnect is our own leave */
+static const wifi_prov_config_t *s_policy = NULL;
 
 static void event_handler(void *arg, esp_event_base_t base,
                           int32_t id, void *data)
 {
     if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retries < s_max_retries) {
+        const wifi_event_sta_disconnected_t *event = data;
+        stats_record(STATS_STA_DISCONNECT, event->reason, 0);
+        if (s_leaving) {
+            s_leaving = false;
+            esp_wifi_connect();
+        } else if (s_retries < s_max_retries) {
             s_retries++;
             ESP_LOGI(TAG, "Retry %d/%d …", s_retries, s_max_retries);
             esp_wifi_connect();
@@ -39,12 +53,99 @@ static void event_handler(void *arg, esp_event_base_t base,
     }
 }
 
-esp_err_t wifi_sta_connect(const char *ssid, const char *password,
-                           uint8_t max_retries)
+/*
+ * Auth mode floor for a network: the configured minimum, raised to what
+ * the network offered when it was scanned. Transition networks keep the
+ * older mode as floor so clients of either generation still associate.
+ */
+static wifi_auth_mode_t authmode_floor(wifi_auth_mode_t scanned)
+{
+    wifi_auth_mode_t floor = s_policy ? s_policy->sta_min_authmode : WIFI_AUTH_OPEN;
+    wifi_auth_mode_t min   = scanned;
+
+    switch (scanned) {
+    case WIFI_AUTH_WPA_WPA2_PSK:  min = WIFI_AUTH_WPA_PSK;  break;
+    case WIFI_AUTH_WPA2_WPA3_PSK: min = WIFI_AUTH_WPA2_PSK; break;
+    case WIFI_AUTH_MAX:           min = WIFI_AUTH_OPEN;     break;
+    default: break;
+    }
+    return min > floor ? min : floor;
+}
+
+static void build_config(wifi_config_t *wifi_config, const wifi_prov_creds_t *creds)
+{
+    memset(wifi_config, 0, sizeof(*wifi_config));
+    strncpy((char *)wifi_config->sta.ssid, creds->ssid,
+            sizeof(wifi_config->sta.ssid) - 1);
+    /* A 64-digit PSK fills the field; the driver needs no terminator then */
+    memcpy(wifi_config->sta.password, creds->password,
+           strnlen(creds->password, sizeof(wifi_config->sta.password)));
+
+    wifi_config->sta.threshold.authmode = authmode_floor(creds->authmode);
+
+    /*
+     * A pinned channel limits the driver's probe to it, and a pinned
+     * BSSID skips the pick among APs of the SSID. Either way the probe
+     * is directed (it names the SSID), which hidden networks need.
+     */
+    wifi_config->sta.channel = creds->channel;
+    if (creds->bssid_set) {
+        memcpy(wifi_config->sta.bssid, creds->bssid, sizeof(wifi_config->sta.bssid));
+        wifi_config->sta.bssid_set = true;
+    }
+
+    /* WPA3 mandates PMF; otherwise use it when the AP offers it */
+    wifi_config->sta.pmf_cfg.capable  = true;
+    wifi_config->sta.pmf_cfg.required =
+        (s_policy && s_policy->sta_pmf_required) ||
+        creds->authmode == WIFI_AUTH_WPA3_PSK;
+
+#if CONFIG_WIFI_PROV_ROAMING
+    /* Take neighbor reports and BSS transition requests, use FT where offered */
+    wifi_config->sta.rm_enabled  = 1;
+    wifi_config->sta.btm_enabled = 1;
+    wifi_config->sta.ft_enabled  = 1;
+#endif
+
+    /* Only used in maximum modem power save; 0 leaves the driver default */
+    wifi_config->sta.listen_interval = s_policy ? s_policy->sta_listen_interval : 0;
+
+    /* H2E lets the SAE password element be derived once, not per attempt */
+    wifi_config->sta.sae_pwe_h2e = s_policy ? s_policy->sta_sae_pwe
+                                            : WPA3_SAE_PWE_BOTH;
+}
+
+static EventGroupHandle_t event_group_create(void)
+{
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    return xEventGroupCreateStatic(&s_event_group_buf);
+#else
+    return xEventGroupCreate();
+#endif
+}
+
+void wifi_sta_set_policy(const wifi_prov_config_t *config)
+{
+    s_policy = config;
+}
+
+/*
+ * Connect with the STA config already set and wait for an IP or for the
+ * retries to run out. With leave_first the current association is
+ * dropped first and the connect only issued once the driver reports it
+ * gone, so the leave is not taken for a failed attempt. An attempt still
+ * running after @p timeout is abandoned and counts as failed.
+ */
+static bool run_connect(uint8_t max_retries, bool leave_first, TickType_t timeout)
 {
     s_retries     = 0;
     s_max_retries = max_retries;
-    s_event_group = xEventGroupCreate();
+    s_leaving     = leave_first;
+    /* Created once and reused, connects come and go with start/stop */
+    if (!s_event_group) {
+        s_event_group = event_group_create();
+    }
+    xEventGroupClearBits(s_event_group, STA_CONNECTED_BIT | STA_FAILED_BIT);
 
     esp_event_handler_instance_t wifi_handler;
     esp_event_handler_instance_t ip_handler;
@@ -56,27 +157,41 @@ esp_err_t wifi_sta_connect(const char *ssid, const char *password,
         IP_EVENT, IP_EVENT_STA_GOT_IP,
         &event_handler, NULL, &ip_handler));
 
-    wifi_config_t wifi_config = {0};
-    strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    ESP_LOGI(TAG, "Connecting to \"%s\" …", ssid);
-    esp_wifi_connect();
+    int64_t t0 = esp_timer_get_time();
+    if (leave_first) {
+        esp_wifi_disconnect();
+    } else {
+        esp_wifi_connect();
+    }
 
     EventBits_t bits = xEventGroupWaitBits(s_event_group,
         STA_CONNECTED_BIT | STA_FAILED_BIT,
-        pdTRUE, pdFALSE, portMAX_DELAY);
+        pdTRUE, pdFALSE, timeout);
 
     esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, wifi_handler);
     esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, ip_handler);
-    vEventGroupDelete(s_event_group);
-    s_event_group = NULL;
+    s_leaving = false;
+    if (!(bits & (STA_CONNECTED_BIT | STA_FAILED_BIT))) {
+        ESP_LOGW(TAG, "Connect timed out");
+        esp_wifi_disconnect();
+    }
+    stats_record(STATS_STA_CONNECT, (bits & STA_CONNECTED_BIT) != 0,
+                 (uint32_t)((esp_timer_get_time() - t0) / 1000));
+
+    return (bits & STA_CONNECTED_BIT) != 0;
+}
 
-    if (bits & STA_CONNECTED_BIT) {
+static esp_err_t connect_once(const wifi_prov_creds_t *creds, uint8_t max_retries)
+{
+    wifi_config_t wifi_config;
+    build_config(&wifi_config, creds);
+
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    ESP_LOGI(TAG, "Connecting to \"%s\" …", creds->ssid);
+    if (run_connect(max_retries, false, portMAX_DELAY)) {
         return ESP_OK;
     }
 
@@ -84,45 +199,77 @@ esp_err_t wifi_sta_connect(const char *ssid, const char *password,
     return ESP_FAIL;
 }
 
-esp_err_t wifi_sta_try_connect(const char *ssid, const char *password)
+/*
+ * Connect with the stored pin first; if the pinned AP is gone (replaced,
+ * moved channel) fall back to a full scan for any AP of the SSID.
+ */
+esp_err_t wifi_sta_connect(const wifi_prov_creds_t *creds, uint8_t max_retries)
 {
-    s_retries     = 0;
-    s_max_retries = 0; /* single attempt — user can retry from the portal */
-    s_event_group = xEventGroupCreate();
+    esp_err_t err = connect_once(creds, max_retries);
+    if (err == ESP_OK || (!creds->bssid_set && creds->channel == 0)) {
+        return err;
+    }
 
-    esp_event_handler_instance_t wifi_handler;
-    esp_event_handler_instance_t ip_handler;
+    ESP_LOGW(TAG, "Pinned AP not reachable, scanning for \"%s\" …", creds->ssid);
+    wifi_prov_creds_t any = *creds;
+    any.bssid_set = false;
+    any.channel   = 0;
+    err = connect_once(&any, max_retries);
+    memset(&any, 0, sizeof(any));
+    return err;
+}
 
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED,
-        &event_handler, NULL, &wifi_handler));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        IP_EVENT, IP_EVENT_STA_GOT_IP,
-        &event_handler, NULL, &ip_handler));
+/*
+ * Single trial connect from a running portal. If the STA was associated
+ * (portal opened next to a live link) the old config is put back when
+ * the new network fails, so the device ends up where it started. The
+ * radio has one STA, so the link is down while the new one is tried:
+ * a network that was not seen in the last scan and is not pinned is
+ * refused up front, and the trial is cut off after TRIAL_TIMEOUT_MS.
+ */
+esp_err_t wifi_sta_try_connect(const wifi_prov_creds_t *creds)
+{
+    wifi_ap_record_t current;
+    wifi_config_t    previous;
+    bool live = esp_wifi_sta_get_ap_info(&current) == ESP_OK &&
+                esp_wifi_get_config(WIFI_IF_STA, &previous) == ESP_OK;
 
-    wifi_config_t wifi_config = {0};
-    strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
+    /* provision_apply() leaves WIFI_AUTH_MAX when the scan missed it */
+    if (live && creds->authmode == WIFI_AUTH_MAX &&
+        !creds->bssid_set && creds->channel == 0) {
+        ESP_LOGW(TAG, "\"%s\" not in range, keeping the current network", creds->ssid);
+        memset(&previous, 0, sizeof(previous));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    wifi_config_t wifi_config;
+    build_config(&wifi_config, creds);
 
     /* Keep current mode (APSTA) — only configure the STA interface */
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    memset(&wifi_config, 0, sizeof(wifi_config));
 
-    ESP_LOGI(TAG, "Trying \"%s\" …", ssid);
-    esp_wifi_connect();
-
-    EventBits_t bits = xEventGroupWaitBits(s_event_group,
-        STA_CONNECTED_BIT | STA_FAILED_BIT,
-        pdTRUE, pdFALSE, portMAX_DELAY);
-
-    esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, wifi_handler);
-    esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, ip_handler);
-    vEventGroupDelete(s_event_group);
-    s_event_group = NULL;
+    ESP_LOGI(TAG, "Trying \"%s\" …", creds->ssid);
+    /* Single attempt — user can retry from the portal */
+    bool ok = run_connect(0, live, pdMS_TO_TICKS(TRIAL_TIMEOUT_MS));
 
-    if (bits & STA_CONNECTED_BIT) {
-        return ESP_OK;
+    if (!ok && live) {
+        ESP_LOGW(TAG, "Restoring connection to \"%s\" …", (const char *)previous.sta.ssid);
+        esp_wifi_set_config(WIFI_IF_STA, &previous);
+        run_connect(s_policy ? s_policy->max_retries : 0, false, portMAX_DELAY);
+    } else if (!ok) {
+        esp_wifi_disconnect();
+    }
+    if (live) {
+        memset(&previous, 0, sizeof(previous));
     }
 
-    esp_wifi_disconnect();
-    return ESP_FAIL;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+/* The default STA netif; transports and the boot path share one */
+esp_netif_t *wifi_sta_netif(void)
+{
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    return netif ? netif : esp_netif_create_default_wifi_sta();
 }
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_RESULTS 64
+#define ROUNDS      5
+
+#ifndef HOST_VARIANT
+#define HOST_VARIANT "plain"
+#endif
+
+typedef struct {
+    char   name[64];
+    double value;
+    char   unit[16];
+} result_t;
+
+static const char *s_suite;
+static const char *s_json;
+static result_t    s_results[MAX_RESULTS];
+static int         s_result_count;
+static unsigned    s_checks;
+static unsigned    s_failures;
+static bool        s_quick;
+
+void bench_init(int argc, char **argv, const char *suite)
+{
+    s_suite = suite;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            s_json = argv[++i];
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            s_quick = true;
+        }
+    }
+    if (getenv("BENCH_QUICK")) {
+        s_quick = true;
+    }
+    printf("%s (%s)\n", suite, HOST_VARIANT);
+}
+
+unsigned bench_iters(unsigned iters)
+{
+    return s_quick && iters >= 10 ? iters / 10 : iters;
+}
+
+void bench_check(bool ok, const char *expr, const char *file, int line)
+{
+    s_checks++;
+    if (!ok) {
+        s_failures++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void bench_metric(const char *name, double value, const char *unit)
+{
+    printf("  %-40s %14.1f %s\n", name, value, unit);
+    if (s_result_count == MAX_RESULTS) {
+        return;
+    }
+    result_t *r = &s_results[s_result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    snprintf(r->unit, sizeof(r->unit), "%s", unit);
+    r->value = value;
+}
+
+double bench_run(const char *name, bench_fn_t fn, void *arg, unsigned iters)
+{
+    iters = bench_iters(iters);
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        int64_t t0 = bench_now_ns();
+        for (unsigned i = 0; i < iters; i++) {
+            fn(arg);
+        }
+        double ns = (double)(bench_now_ns() - t0) / iters;
+        if (round == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    bench_metric(name, best, "ns/op");
+    return best;
+}
+
+static void json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', f);
+        }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+int bench_finish(void)
+{
+    printf("  %u checks, %u failed\n", s_checks, s_failures);
+
+    if (s_json) {
+        FILE *f = fopen(s_json, "w");
+        if (!f) {
+            perror(s_json);
+            return 1;
+        }
+        fprintf(f, "{\n  \"suite\": ");
+        json_string(f, s_suite);
+        fprintf(f, ",\n  \"variant\": ");
+        json_string(f, HOST_VARIANT);
+        fprintf(f, ",\n  \"checks\": %u,\n  \"failures\": %u,\n  \"results\": [",
+                s_checks, s_failures);
+        for (int i = 0; i < s_result_count; i++) {
+            fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+            json_string(f, s_results[i].name);
+            fprintf(f, ", \"value\": %.3f, \"unit\": ", s_results[i].value);
+            json_string(f, s_results[i].unit);
+            fputc('}', f);
+        }
+        fprintf(f, "\n  ]\n}\n");
+        fclose(f);
+    }
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Shared by the host tests and benchmarks: checks, timing and the
+ * results file. Every program takes --json <file> and writes its
+ * measurements and check counts there, so runs can be compared.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*bench_fn_t)(void *arg);
+
+void bench_init(int argc, char **argv, const char *suite);
+/* Writes the results file; the exit code for main() */
+int  bench_finish(void);
+
+void bench_check(bool ok, const char *expr, const char *file, int line);
+#define CHECK(cond) bench_check((cond), #cond, __FILE__, __LINE__)
+
+/* Monotonic wall clock, unaffected by host_clock_skip_waits() */
+int64_t bench_now_ns(void);
+
+/* Best of a few rounds of @p iters calls, recorded as ns/op */
+double bench_run(const char *name, bench_fn_t fn, void *arg, unsigned iters);
+void   bench_metric(const char *name, double value, const char *unit);
+
+/* Iteration count scaled down when BENCH_QUICK is set */
+unsigned bench_iters(unsigned iters);
@@ -0,0 +1,179 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Micro-benchmarks of the portal codecs (portal_codec.c): form
+ * decoding, the /scan and /config JSON and DNS answers. Each one is
+ * checked against a known output before it is timed.
+ */
+
+#include "bench.h"
+#include "wifi_prov_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SCAN_COUNT 32
+
+/* ── Form decoding ──────────────────────────────────────────────────── */
+
+static const char FORM_BODY[] =
+    "ssid=Caf%C3%A9+Guest%2B%26+5G&password=p%40ss+w%25rd%21%21&bssid=&channel=0";
+
+static void run_hex_val(void *arg)
+{
+    static const char digits[] = "0123456789abcdefABCDEFxyz";
+    volatile int sum = 0;
+    for (const char *c = digits; *c; c++) {
+        sum += hex_val(*c);
+    }
+}
+
+static void run_url_decode(void *arg)
+{
+    char out[65];
+    url_decode(out, sizeof(out), FORM_BODY, sizeof(FORM_BODY) - 1);
+}
+
+static void run_form_fields(void *arg)
+{
+    char ssid[33];
+    char password[65];
+    form_field(FORM_BODY, "ssid", ssid, sizeof(ssid));
+    form_field(FORM_BODY, "password", password, sizeof(password));
+}
+
+static void check_form(void)
+{
+    int sum = 0;
+    for (const char *c = "0123456789abcdefABCDEF"; *c; c++) {
+        sum += hex_val(*c);
+    }
+    CHECK(sum == 120 + 75);
+    CHECK(hex_val('g') == -1 && hex_val('%') == -1);
+
+    char ssid[33];
+    char password[65];
+    CHECK(form_field(FORM_BODY, "ssid", ssid, sizeof(ssid)));
+    CHECK(strcmp(ssid, "Caf\xC3\xA9 Guest+& 5G") == 0);
+    CHECK(form_field(FORM_BODY, "password", password, sizeof(password)));
+    CHECK(strcmp(password, "p@ss w%rd!!") == 0);
+
+    char small[4];
+    url_decode(small, sizeof(small), "abcdef", 6);
+    CHECK(strcmp(small, "abc") == 0);
+    url_decode(small, sizeof(small), "%4", 2);
+    CHECK(strcmp(small, "%4") == 0);
+}
+
+/* ── JSON ───────────────────────────────────────────────────────────── */
+
+static wifi_scan_entry_t s_nets[SCAN_COUNT];
+static char              s_json[16384];
+
+static void run_json_networks(void *arg)
+{
+    json_networks(s_json, s_nets, SCAN_COUNT);
+}
+
+static const wifi_prov_config_t s_branding = {
+    .page_title          = "WiFi Setup",
+    .portal_header       = "Welcome to \"Acme\"",
+    .portal_subheader    = "Pick a network\nand enter its password.",
+    .connected_header    = "Connected!",
+    .connected_subheader = "You can close this page.",
+    .page_footer         = NULL,
+};
+
+static void run_json_branding(void *arg)
+{
+    json_branding(s_json, &s_branding);
+}
+
+static void run_json_branding_sized(void *arg)
+{
+    size_t len = json_branding(NULL, &s_branding);
+    json_branding(s_json, &s_branding);
+    (void)len;
+}
+
+static void check_json(void)
+{
+    for (int i = 0; i < SCAN_COUNT; i++) {
+        snprintf(s_nets[i].ssid, sizeof(s_nets[i].ssid), "Network %02d \"%c\"", i, 'A' + i % 26);
+        s_nets[i].rssi     = (int8_t)(-40 - i);
+        s_nets[i].authmode = WIFI_AUTH_WPA2_PSK;
+        s_nets[i].channel  = (uint8_t)(1 + i % 13);
+    }
+    s_nets[SCAN_COUNT - 1].ssid[0] = '\0';  /* one hidden network */
+    memcpy(s_nets[SCAN_COUNT - 1].bssid, "\x24\x0a\xc4\x01\x02\x03", 6);
+
+    CHECK(json_networks_max(SCAN_COUNT) <= sizeof(s_json));
+    size_t len = json_networks(s_json, s_nets, SCAN_COUNT);
+    CHECK(len == strlen(s_json));
+    static const char first[] = "[{\"ssid\":\"Network 00 \\\"A\\\"\",\"rssi\":-40,\"auth\":3},";
+    CHECK(strncmp(s_json, first, sizeof(first) - 1) == 0);
+    CHECK(strstr(s_json, "{\"ssid\":\"\",\"rssi\":-71,\"auth\":3,"
+                         "\"bssid\":\"24:0a:c4:01:02:03\",\"ch\":6}]") != NULL);
+
+    wifi_scan_entry_t worst = { .rssi = -128, .authmode = 99, .channel = 255 };
+    memset(worst.ssid, '\x01', 32);
+    len = json_networks(s_json, &worst, 1);
+    CHECK(len + 1 <= json_networks_max(1));
+
+    len = json_branding(NULL, &s_branding);
+    CHECK(json_branding(s_json, &s_branding) == len);
+    CHECK(strlen(s_json) == len);
+    CHECK(strstr(s_json, "\"portal_header\":\"Welcome to \\\"Acme\\\"\"") != NULL);
+    CHECK(strstr(s_json, "\\u000a") != NULL);
+    CHECK(strstr(s_json, "\"footer\":\"\"}") != NULL);
+}
+
+/* ── DNS ────────────────────────────────────────────────────────────── */
+
+/* A query for connectivitycheck.gstatic.com */
+static const uint8_t DNS_QUERY[] = {
+    0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    17, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+    7, 'g', 's', 't', 'a', 't', 'i', 'c', 3, 'c', 'o', 'm', 0,
+    0x00, 0x01, 0x00, 0x01,
+};
+
+static void run_dns(void *arg)
+{
+    uint8_t buf[512];
+    memcpy(buf, DNS_QUERY, sizeof(DNS_QUERY));
+    dns_build_response(buf, sizeof(DNS_QUERY), sizeof(buf), 0x0104A8C0);
+}
+
+static void check_dns(void)
+{
+    uint8_t buf[512];
+    memcpy(buf, DNS_QUERY, sizeof(DNS_QUERY));
+    size_t len = dns_build_response(buf, sizeof(DNS_QUERY), sizeof(buf), 0x0104A8C0);
+    CHECK(len == sizeof(DNS_QUERY) + 16);
+    CHECK(buf[0] == 0x12 && buf[1] == 0x34 && buf[2] == 0x81 && buf[7] == 1);
+    CHECK(memcmp(buf + len - 4, "\xc0\xa8\x04\x01", 4) == 0);
+
+    CHECK(dns_build_response(buf, 11, sizeof(buf), 0) == 0);
+    CHECK(dns_build_response(buf, sizeof(DNS_QUERY), sizeof(DNS_QUERY) + 15, 0) == 0);
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "codec");
+
+    check_form();
+    check_json();
+    check_dns();
+
+    bench_run("hex_val x22",                run_hex_val,             NULL, 1000000);
+    bench_run("url_decode",                 run_url_decode,          NULL, 1000000);
+    bench_run("form_field ssid+password",   run_form_fields,         NULL, 1000000);
+    bench_run("json_networks 32",           run_json_networks,       NULL, 100000);
+    bench_run("json_branding",              run_json_branding,       NULL, 1000000);
+    bench_run("json_branding size+fill",    run_json_branding_sized, NULL, 1000000);
+    bench_run("dns_build_response",         run_dns,                 NULL, 1000000);
+
+    return bench_finish();
+}
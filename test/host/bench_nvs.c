@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * What loading the stored credentials costs at boot. With
+ * CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS the first load asks the key
+ * provider once and sets up the key; every later load is one AEAD
+ * decrypt with the cached key. A substitute provider stands in for the
+ * eFuse HMAC and counts its calls. The plain variant times the same
+ * loads from plaintext records for comparison.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+static unsigned s_key_requests;
+
+static esp_err_t counted_key(uint8_t key[32])
+{
+    s_key_requests++;
+    return test_key(key);
+}
+
+static esp_err_t other_key(uint8_t key[32])
+{
+    memset(key, 0xa5, 32);
+    return ESP_OK;
+}
+#endif
+
+static bool loads_stored(void)
+{
+    wifi_prov_creds_t creds = {0};
+    return nvs_store_load(&creds) == ESP_OK &&
+           strcmp(creds.ssid, HOME_SSID) == 0 &&
+           strcmp(creds.password, HOME_PASSWORD) == 0 &&
+           creds.authmode == WIFI_AUTH_WPA2_PSK;
+}
+
+static void run_load(void *arg)
+{
+    wifi_prov_creds_t creds;
+    nvs_store_load(&creds);
+}
+
+static void run_load_pmk(void *arg)
+{
+    char psk[WIFI_PMK_LEN * 2 + 1];
+    nvs_store_load_pmk(HOME_SSID, psk, sizeof(psk));
+}
+
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+/* As on every boot: a fresh key cache, so the provider is asked again */
+static void run_load_cold(void *arg)
+{
+    wifi_prov_creds_t creds;
+    wifi_prov_set_key_provider(counted_key);
+    nvs_store_load(&creds);
+}
+
+/* The AEAD share of a load: opening a sealed password alone */
+static void run_open(void *arg)
+{
+    static crypto_key_t key;
+    static uint8_t      blob[CRYPTO_OVERHEAD + sizeof(HOME_PASSWORD)];
+    static size_t       blob_len;
+    if (!key.ready) {
+        uint8_t material[CRYPTO_KEY_LEN];
+        test_key(material);
+        crypto_key_init(&key, material);
+        blob_len = sizeof(blob);
+        crypto_seal(&key, HOME_PASSWORD, sizeof(HOME_PASSWORD),
+                    HOME_SSID, strlen(HOME_SSID), blob, &blob_len);
+    }
+    char   password[sizeof(HOME_PASSWORD)];
+    size_t len = sizeof(password);
+    crypto_open(&key, blob, blob_len, HOME_SSID, strlen(HOME_SSID), password, &len);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "nvs");
+
+    host_clock_skip_waits(true, NULL);
+    CHECK(wifi_prov_init() == ESP_OK);
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    CHECK(wifi_prov_set_key_provider(counted_key) == ESP_OK);
+#endif
+
+    wifi_prov_creds_t creds = { .ssid = HOME_SSID, .password = HOME_PASSWORD,
+                                .authmode = WIFI_AUTH_WPA2_PSK };
+    CHECK(nvs_store_save(&creds) == ESP_OK);
+    CHECK(loads_stored());
+    char psk[WIFI_PMK_LEN * 2 + 1];
+    CHECK(nvs_store_load_pmk(HOME_SSID, psk, sizeof(psk)) == ESP_OK && strlen(psk) == 64);
+
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    CHECK(!host_nvs_has("wifi_prov", "pass"));
+
+    /* Asked once per boot, however often the record is read */
+    s_key_requests = 0;
+    CHECK(wifi_prov_set_key_provider(counted_key) == ESP_OK);
+    for (int i = 0; i < 10; i++) {
+        CHECK(loads_stored());
+    }
+    CHECK(s_key_requests == 1);
+
+    /* Another device's key opens nothing */
+    CHECK(wifi_prov_set_key_provider(other_key) == ESP_OK);
+    CHECK(!loads_stored());
+    CHECK(wifi_prov_set_key_provider(counted_key) == ESP_OK);
+    CHECK(loads_stored());
+
+    bench_run("boot load, key setup", run_load_cold, NULL, 2000);
+#endif
+    bench_run("load", run_load, NULL, 20000);
+    bench_run("load PMK", run_load_pmk, NULL, 20000);
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    bench_run("AEAD open", run_open, NULL, 20000);
+#endif
+
+    return bench_finish();
+}
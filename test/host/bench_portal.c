@@ -0,0 +1,310 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * End to end through the captive portal: boot without credentials,
+ * fetch the page, branding and scan the way the browser does, answer a
+ * DNS probe, save credentials and end up connected with the portal
+ * gone. Request handling is timed on the way.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_WIFI_PROV_HTTPS
+#define PORTAL_PORT  CONFIG_WIFI_PROV_HTTPS_PORT
+#define HTTP_SERVERS 2  /* portal and redirect */
+#else
+#define PORTAL_PORT  CONFIG_WIFI_PROV_HTTP_PORT
+#define HTTP_SERVERS 1
+#endif
+
+#define NEIGHBOURS 20
+
+static host_http_resp_t s_resp;
+
+/* ── Simulated surroundings ─────────────────────────────────────────── */
+
+static void add_networks(void)
+{
+    static const host_ap_t aps[] = {
+        { "Cafe Guest", { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02 }, 1,  -71,
+          WIFI_AUTH_OPEN, NULL },
+        { "Office",     { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x03 }, 11, -63,
+          WIFI_AUTH_WPA2_WPA3_PSK, "office-pass-2026" },
+    };
+    static char names[NEIGHBOURS][16];
+
+    for (int i = 0; i < (int)(sizeof(aps) / sizeof(aps[0])); i++) {
+        host_wifi_add_ap(&aps[i]);
+    }
+    for (int i = 0; i < NEIGHBOURS; i++) {
+        snprintf(names[i], sizeof(names[i]), "Neighbour %02d", i);
+        host_ap_t ap = {
+            .ssid     = names[i],
+            .bssid    = { 0x3c, 0x71, 0xbf, 0x00, 0x01, (uint8_t)i },
+            .channel  = (uint8_t)(1 + i % 13),
+            .rssi     = (int8_t)(-60 - i),
+            .authmode = WIFI_AUTH_WPA2_PSK,
+            .password = "not-ours-at-all",
+        };
+        host_wifi_add_ap(&ap);
+    }
+}
+
+/* ── Requests ───────────────────────────────────────────────────────── */
+
+static void get(const char *uri, const char *headers)
+{
+    host_http_request(PORTAL_PORT, HTTP_GET, uri, headers, NULL, &s_resp);
+}
+
+static bool body_has(const char *needle)
+{
+    static char body[16384];   /* the whole plain page */
+    size_t n = s_resp.body_len < sizeof(body) - 1 ? s_resp.body_len : sizeof(body) - 1;
+    memcpy(body, s_resp.body ? s_resp.body : "", n);
+    body[n] = '\0';
+    return strstr(body, needle) != NULL;
+}
+
+static void run_get_root(void *arg)
+{
+    get("/", "Accept-Language: de-CH,de;q=0.9,en;q=0.8\r\nAccept-Encoding: gzip, deflate\r\n");
+}
+
+static void run_get_config(void *arg)
+{
+    get("/config", NULL);
+}
+
+static void run_get_config_cached(void *arg)
+{
+    get("/config", arg);
+}
+
+static void run_get_scan(void *arg)
+{
+    get("/scan", NULL);
+}
+
+static void run_get_probe(void *arg)
+{
+    get("/generate_204", NULL);
+}
+
+/* A query for connectivitycheck.gstatic.com */
+static const uint8_t DNS_QUERY[] = {
+    0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    17, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+    7, 'g', 's', 't', 'a', 't', 'i', 'c', 3, 'c', 'o', 'm', 0,
+    0x00, 0x01, 0x00, 0x01,
+};
+
+static int dns_query(uint8_t *reply, size_t cap)
+{
+    return host_udp_request(53, DNS_QUERY, sizeof(DNS_QUERY), reply, cap, 1000);
+}
+
+static void run_dns(void *arg)
+{
+    uint8_t reply[128];
+    dns_query(reply, sizeof(reply));
+}
+
+#if CONFIG_WIFI_PROV_STATS
+#define EVENT_DUMPS 200
+
+static atomic_bool s_logging;
+
+static void *log_events(void *arg)
+{
+    /* Bursts of short and long entries, so the dump size keeps moving */
+    for (uint32_t i = 0; atomic_load(&s_logging); i++) {
+        bool wide = i & 64;
+        stats_record(STATS_SCAN, wide ? UINT16_MAX : 0, wide ? UINT32_MAX : 0);
+    }
+    return NULL;
+}
+
+/* The event log keeps growing while /debug/events renders it */
+static void check_events(void)
+{
+    pthread_t logger;
+    atomic_store(&s_logging, true);
+    pthread_create(&logger, NULL, log_events, NULL);
+
+    unsigned complete = 0;
+    for (int i = 0; i < EVENT_DUMPS; i++) {
+        get("/debug/events", NULL);
+        complete += strcmp(s_resp.status, "200 OK") == 0 && s_resp.body_len > 2 &&
+                    memcmp(s_resp.body + s_resp.body_len - 2, "]}", 2) == 0;
+    }
+    CHECK(complete == EVENT_DUMPS);
+
+    atomic_store(&s_logging, false);
+    pthread_join(logger, NULL);
+}
+#endif
+
+/* ── Flow ───────────────────────────────────────────────────────────── */
+
+static void check_pages(void)
+{
+    char value[64];
+
+    run_get_root(NULL);
+    CHECK(strcmp(s_resp.status, "200 OK") == 0);
+    CHECK(s_resp.body_len > 2 && (uint8_t)s_resp.body[0] == 0x1f &&
+          (uint8_t)s_resp.body[1] == 0x8b);
+    CHECK(host_http_header(&s_resp, "Content-Encoding", value, sizeof(value)) &&
+          strcmp(value, "gzip") == 0);
+    CHECK(host_http_header(&s_resp, "Vary", value, sizeof(value)) &&
+          strcmp(value, "Accept-Language, Accept-Encoding") == 0);
+
+    /* No gzip on offer: the default page, uncompressed */
+    static const char *const no_gzip[] = {
+        NULL,
+        "Accept-Encoding: identity\r\n",
+        "Accept-Encoding: br, gzip;q=0, *\r\n",
+        "Accept-Encoding: deflate, *;q=0\r\n",
+    };
+    for (size_t i = 0; i < sizeof(no_gzip) / sizeof(no_gzip[0]); i++) {
+        get("/", no_gzip[i]);
+        CHECK(strcmp(s_resp.status, "200 OK") == 0);
+        CHECK(!host_http_header(&s_resp, "Content-Encoding", value, sizeof(value)));
+        CHECK(body_has("<html lang=\"en\">"));
+    }
+    /* In the client's language all the same, script strings included */
+    get("/", "Accept-Language: de\r\nAccept-Encoding: identity\r\n");
+    CHECK(!host_http_header(&s_resp, "Content-Encoding", value, sizeof(value)));
+    CHECK(body_has("<html lang=\"de\">") && body_has(">Verbinden</button>"));
+    CHECK(body_has("btn.textContent = 'Verbinden'") && !body_has("t('Connect')"));
+    get("/", "Accept-Encoding: br;q=1.0, *;q=0.5\r\n");
+    CHECK(host_http_header(&s_resp, "Content-Encoding", value, sizeof(value)) &&
+          strcmp(value, "gzip") == 0);
+
+    run_get_config(NULL);
+    CHECK(strcmp(s_resp.status, "200 OK") == 0);
+    CHECK(body_has("\"title\":\"Acme Setup\""));
+    char etag[32];
+    CHECK(host_http_header(&s_resp, "ETag", etag, sizeof(etag)) != NULL);
+    static char if_none_match[64];
+    snprintf(if_none_match, sizeof(if_none_match), "If-None-Match: %s\r\n", etag);
+    run_get_config_cached(if_none_match);
+    CHECK(strcmp(s_resp.status, "304 Not Modified") == 0 && s_resp.body_len == 0);
+
+    run_get_scan(NULL);
+    CHECK(strcmp(s_resp.status, "200 OK") == 0);
+    CHECK(body_has("\"ssid\":\"HomeNet\",\"rssi\":-48,\"auth\":3"));
+    CHECK(body_has("\"ssid\":\"Neighbour 19\""));
+
+    run_get_probe(NULL);
+    CHECK(strcmp(s_resp.status, "302 Found") == 0);
+    CHECK(host_http_header(&s_resp, "Location", value, sizeof(value)) != NULL);
+
+#if CONFIG_WIFI_PROV_HTTPS
+    host_http_request(CONFIG_WIFI_PROV_HTTP_PORT, HTTP_GET, "/hotspot-detect.html",
+                      NULL, NULL, &s_resp);
+    CHECK(strcmp(s_resp.status, "302 Found") == 0);
+    CHECK(host_http_header(&s_resp, "Location", value, sizeof(value)) &&
+          strncmp(value, "https://", 8) == 0);
+#endif
+
+    uint8_t reply[128];
+    int len = dns_query(reply, sizeof(reply));
+    CHECK(len == (int)sizeof(DNS_QUERY) + 16);
+    CHECK(len > 4 && memcmp(reply + len - 4, "\xc0\xa8\x04\x01", 4) == 0);
+
+    bench_run("GET / (gzip, de)",          run_get_root,          NULL, 20000);
+    bench_run("GET /config",               run_get_config,        NULL, 20000);
+    bench_run("GET /config (304)",         run_get_config_cached, if_none_match, 20000);
+    bench_run("GET /scan (reused)",        run_get_scan,          NULL, 2000);
+    bench_run("GET /generate_204",         run_get_probe,         NULL, 20000);
+    bench_run("DNS round trip",            run_dns,               NULL, 2000);
+}
+
+static void check_save(void)
+{
+    host_http_request(PORTAL_PORT, HTTP_POST, "/save", NULL,
+                      "ssid=HomeNet&password=wrong+password&bssid=&channel=", &s_resp);
+    CHECK(body_has("{\"success\":false}"));
+    CHECK(!wifi_prov_is_connected() && host_httpd_running() > 0);
+
+    host_http_request(PORTAL_PORT, HTTP_POST, "/save", NULL,
+                      "ssid=&password=", &s_resp);
+    CHECK(strncmp(s_resp.status, "400", 3) == 0 || body_has("{\"success\":false}"));
+
+    int64_t t0 = bench_now_ns();
+    host_http_request(PORTAL_PORT, HTTP_POST, "/save", NULL,
+                      "ssid=HomeNet&password=correct+horse+battery&bssid=&channel=",
+                      &s_resp);
+    bench_metric("POST /save to connected", (double)(bench_now_ns() - t0) / 1e6, "ms");
+    CHECK(body_has("{\"success\":true}"));
+    CHECK(wifi_prov_wait_for_connection(0) == ESP_OK);
+    CHECK(host_httpd_running() == 0);
+    CHECK(host_sockets_open() == 0);
+    CHECK(host_wifi()->mode == WIFI_MODE_STA && host_wifi()->associated);
+    CHECK(host_wifi()->ps == WIFI_PS_MIN_MODEM);
+
+    wifi_prov_radio_stats_t radio;
+    CHECK(wifi_prov_get_radio_stats(&radio) == ESP_OK &&
+          radio.state == WIFI_PROV_RADIO_POWER_SAVE);
+
+    wifi_prov_creds_t creds;
+    CHECK(nvs_store_load(&creds) == ESP_OK && strcmp(creds.ssid, HOME_SSID) == 0);
+
+    esp_netif_ip_info_t ip;
+    CHECK(wifi_prov_get_ip_info(&ip) == ESP_OK);
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "portal");
+
+    /* Listen windows and retry back-off pass instantly */
+    host_clock_skip_waits(true, NULL);
+    host_fixture_init();
+    add_networks();
+
+    /* Branding set before start survives it */
+    CHECK(wifi_prov_set_branding(&(wifi_prov_branding_t){
+        .page_title          = "Acme Setup",
+        .portal_header       = "Welcome",
+        .connected_header    = "Connected!",
+    }) == ESP_OK);
+
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    int64_t t0 = bench_now_ns();
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    bench_metric("start to portal", (double)(bench_now_ns() - t0) / 1e6, "ms");
+
+    CHECK(!wifi_prov_is_connected());
+    CHECK(host_httpd_running() == HTTP_SERVERS);
+    CHECK(host_sockets_open() == 1);
+#if CONFIG_BT_ENABLED
+    CHECK(host_wifi()->ps == WIFI_PS_MIN_MODEM); /* coexistence needs modem sleep */
+#else
+    CHECK(host_wifi()->ps == WIFI_PS_NONE);
+#endif
+
+    check_pages();
+#if CONFIG_WIFI_PROV_STATS
+    check_events();
+#endif
+    check_save();
+
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(host_tasks_alive() == 0);
+    host_http_resp_free(&s_resp);
+
+    return bench_finish();
+}
@@ -0,0 +1,299 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * TLS handshakes against the portal certificate: a full handshake
+ * (ECDHE, ECDSA P-256) next to one resumed from a session ticket, as
+ * when a phone reconnects to the portal. esp_https_server is not part
+ * of the host build, so the server side is set up the way esp-tls sets
+ * it up for the portal: the certificate from tls_cert_load(), and with
+ * CONFIG_ESP_TLS_SERVER_SESSION_TICKETS, tickets sealed with AES-256-GCM.
+ * Client and server run in one thread and talk through in-memory pipes.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PIPE_SIZE        16384
+#define HANDSHAKE_ROUNDS 64     /* flights back and forth before giving up */
+#define TICKET_LIFETIME  86400  /* esp-tls default */
+
+typedef struct {
+    unsigned char buf[PIPE_SIZE];
+    size_t        len;
+    size_t        total;        /* bytes ever written */
+} pipe_t;
+
+typedef struct {
+    pipe_t *tx;
+    pipe_t *rx;
+} link_t;
+
+typedef struct {
+    bool   ok;
+    bool   resumed;
+    size_t bytes;               /* both directions */
+} handshake_t;
+
+static mbedtls_entropy_context  s_entropy;
+static mbedtls_ctr_drbg_context s_drbg;
+static mbedtls_x509_crt         s_crt;
+static mbedtls_pk_context       s_key;
+static mbedtls_ssl_config       s_server_conf;
+static mbedtls_ssl_config       s_client_conf;
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+static mbedtls_ssl_ticket_context s_ticket;
+#endif
+static mbedtls_ssl_session      s_session;
+static unsigned                 s_tickets_parsed;
+
+static pipe_t s_to_server;
+static pipe_t s_to_client;
+
+/* ── Pipes ──────────────────────────────────────────────────────────── */
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    pipe_t *p = ((link_t *)ctx)->tx;
+    size_t n = len < PIPE_SIZE - p->len ? len : PIPE_SIZE - p->len;
+    if (n == 0) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    memcpy(p->buf + p->len, buf, n);
+    p->len   += n;
+    p->total += n;
+    return (int)n;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    pipe_t *p = ((link_t *)ctx)->rx;
+    size_t n = len < p->len ? len : p->len;
+    if (n == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    memcpy(buf, p->buf, n);
+    memmove(p->buf, p->buf + n, p->len - n);
+    p->len -= n;
+    return (int)n;
+}
+
+/* ── Endpoints ──────────────────────────────────────────────────────── */
+
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+static int count_parse(void *p_ticket, mbedtls_ssl_session *session,
+                       unsigned char *buf, size_t len)
+{
+    int ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+    s_tickets_parsed += ret == 0;
+    return ret;
+}
+#endif
+
+static bool setup(void)
+{
+    tls_cert_t cert = {0};
+    int ret = tls_cert_load(&cert) == ESP_OK ? 0 : -1;
+
+    mbedtls_entropy_init(&s_entropy);
+    mbedtls_ctr_drbg_init(&s_drbg);
+    mbedtls_x509_crt_init(&s_crt);
+    mbedtls_pk_init(&s_key);
+    mbedtls_ssl_config_init(&s_server_conf);
+    mbedtls_ssl_config_init(&s_client_conf);
+    mbedtls_ssl_session_init(&s_session);
+
+    if (ret == 0) {
+        ret = mbedtls_ctr_drbg_seed(&s_drbg, mbedtls_entropy_func, &s_entropy, NULL, 0);
+    }
+    if (ret == 0) {
+        ret = mbedtls_x509_crt_parse(&s_crt, (const unsigned char *)cert.cert_pem,
+                                     cert.cert_len);
+    }
+    if (ret == 0) {
+#if MBEDTLS_VERSION_MAJOR >= 3
+        ret = mbedtls_pk_parse_key(&s_key, (const unsigned char *)cert.key_pem,
+                                   cert.key_len, NULL, 0, mbedtls_ctr_drbg_random, &s_drbg);
+#else
+        ret = mbedtls_pk_parse_key(&s_key, (const unsigned char *)cert.key_pem,
+                                   cert.key_len, NULL, 0);
+#endif
+    }
+    tls_cert_free(&cert);
+
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&s_server_conf, MBEDTLS_SSL_IS_SERVER,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_rng(&s_server_conf, mbedtls_ctr_drbg_random, &s_drbg);
+        ret = mbedtls_ssl_conf_own_cert(&s_server_conf, &s_crt, &s_key);
+    }
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    mbedtls_ssl_ticket_init(&s_ticket);
+    if (ret == 0) {
+        ret = mbedtls_ssl_ticket_setup(&s_ticket, mbedtls_ctr_drbg_random, &s_drbg,
+                                       MBEDTLS_CIPHER_AES_256_GCM, TICKET_LIFETIME);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_session_tickets_cb(&s_server_conf, mbedtls_ssl_ticket_write,
+                                            count_parse, &s_ticket);
+    }
+#endif
+
+    /* A phone accepting the self-signed certificate */
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&s_client_conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_rng(&s_client_conf, mbedtls_ctr_drbg_random, &s_drbg);
+        mbedtls_ssl_conf_authmode(&s_client_conf, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_session_tickets(&s_client_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    }
+    return ret == 0;
+}
+
+static void teardown(void)
+{
+    mbedtls_ssl_session_free(&s_session);
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    mbedtls_ssl_ticket_free(&s_ticket);
+#endif
+    mbedtls_ssl_config_free(&s_client_conf);
+    mbedtls_ssl_config_free(&s_server_conf);
+    mbedtls_pk_free(&s_key);
+    mbedtls_x509_crt_free(&s_crt);
+    mbedtls_ctr_drbg_free(&s_drbg);
+    mbedtls_entropy_free(&s_entropy);
+}
+
+/* One connection; resumes from s_session if @p resume, else saves it */
+static handshake_t handshake(bool resume)
+{
+    mbedtls_ssl_context client;
+    mbedtls_ssl_context server;
+    link_t client_link = { .tx = &s_to_server, .rx = &s_to_client };
+    link_t server_link = { .tx = &s_to_client, .rx = &s_to_server };
+    handshake_t result = {0};
+    unsigned parsed = s_tickets_parsed;
+
+    memset(&s_to_server, 0, sizeof(s_to_server));
+    memset(&s_to_client, 0, sizeof(s_to_client));
+    mbedtls_ssl_init(&client);
+    mbedtls_ssl_init(&server);
+
+    int ret = mbedtls_ssl_setup(&client, &s_client_conf);
+    if (ret == 0) {
+        ret = mbedtls_ssl_setup(&server, &s_server_conf);
+    }
+    if (ret == 0 && resume) {
+        ret = mbedtls_ssl_set_session(&client, &s_session);
+    }
+    mbedtls_ssl_set_bio(&client, &client_link, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_bio(&server, &server_link, pipe_send, pipe_recv, NULL);
+
+    int client_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    int server_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    for (int i = 0; ret == 0 && i < HANDSHAKE_ROUNDS; i++) {
+        if (client_ret != 0) {
+            client_ret = mbedtls_ssl_handshake(&client);
+        }
+        if (server_ret != 0) {
+            server_ret = mbedtls_ssl_handshake(&server);
+        }
+        if (client_ret == 0 && server_ret == 0) {
+            break;
+        }
+        if ((client_ret != 0 && client_ret != MBEDTLS_ERR_SSL_WANT_READ &&
+             client_ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            (server_ret != 0 && server_ret != MBEDTLS_ERR_SSL_WANT_READ &&
+             server_ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+            ret = client_ret ? client_ret : server_ret;
+        }
+    }
+
+    result.ok = ret == 0 && client_ret == 0 && server_ret == 0;
+    if (result.ok && !resume) {
+        mbedtls_ssl_session_free(&s_session);
+        mbedtls_ssl_session_init(&s_session);
+        result.ok = mbedtls_ssl_get_session(&client, &s_session) == 0;
+    }
+    result.resumed = s_tickets_parsed > parsed;
+    result.bytes   = s_to_server.total + s_to_client.total;
+
+    mbedtls_ssl_free(&server);
+    mbedtls_ssl_free(&client);
+    return result;
+}
+
+static void run_full(void *arg)
+{
+    handshake(false);
+}
+
+static void run_resumed(void *arg)
+{
+    handshake(true);
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "tls");
+
+    host_clock_skip_waits(true, NULL);
+    CHECK(wifi_prov_init() == ESP_OK);
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    CHECK(arena_init(CONFIG_WIFI_PROV_ARENA_SIZE) == ESP_OK);
+#endif
+
+    /* First boot generates and stores the certificate, later ones load it */
+    tls_cert_t cert = {0};
+    int64_t t0 = bench_now_ns();
+    CHECK(tls_cert_load(&cert) == ESP_OK);
+    int64_t t1 = bench_now_ns();
+    tls_cert_free(&cert);
+    CHECK(tls_cert_load(&cert) == ESP_OK);
+    int64_t t2 = bench_now_ns();
+    tls_cert_free(&cert);
+    bench_metric("certificate, first boot", (t1 - t0) / 1e6, "ms");
+    bench_metric("certificate, later boots", (t2 - t1) / 1e6, "ms");
+
+    CHECK(setup());
+
+    handshake_t full = handshake(false);
+    CHECK(full.ok && !full.resumed);
+    handshake_t resumed = handshake(true);
+    CHECK(resumed.ok);
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    CHECK(resumed.resumed);
+    CHECK(resumed.bytes < full.bytes);
+#endif
+
+    double full_ns    = bench_run("full handshake", run_full, NULL, 20);
+    double resumed_ns = bench_run("resumed handshake", run_resumed, NULL, 20);
+    bench_metric("full handshake bytes", full.bytes, "bytes");
+    bench_metric("resumed handshake bytes", resumed.bytes, "bytes");
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    /* Resumption skips the ECDHE exchange and the ECDSA signature */
+    CHECK(resumed_ns * 2 < full_ns);
+    bench_metric("resumption speedup", full_ns / resumed_ns, "x");
+#endif
+
+    teardown();
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    arena_release();
+#endif
+    return bench_finish();
+}
@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "host_fixture.h"
+#include "host_fake.h"
+#include "wifi_provisioner.h"
+
+#include <string.h>
+
+esp_err_t test_key(uint8_t key[32])
+{
+    memset(key, 0x5a, 32);
+    return ESP_OK;
+}
+
+void home_network_add(void)
+{
+    host_wifi_add_ap(&(host_ap_t){
+        .ssid     = HOME_SSID,
+        .bssid    = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 },
+        .channel  = HOME_CHANNEL,
+        .rssi     = -48,
+        .authmode = WIFI_AUTH_WPA2_PSK,
+        .password = HOME_PASSWORD,
+    });
+}
+
+void host_fixture_init(void)
+{
+    home_network_add();
+#if CONFIG_WIFI_PROV_ENCRYPT_CREDENTIALS
+    wifi_prov_set_key_provider(test_key);
+#endif
+}
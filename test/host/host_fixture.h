@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Surroundings shared by the host tests and benchmarks: the home network
+ * a device is provisioned onto, and a storage key standing in for the
+ * eFuse HMAC the host does not have.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+#define HOME_SSID     "HomeNet"
+#define HOME_PASSWORD "correct horse battery"
+#define HOME_CHANNEL  6
+
+/* Fixed key material, the same on every run */
+esp_err_t test_key(uint8_t key[32]);
+
+/* Puts the home network on the air, WPA2-PSK on HOME_CHANNEL */
+void home_network_add(void);
+
+/* The home network, and test_key() as the provider for encrypted storage */
+void host_fixture_init(void);
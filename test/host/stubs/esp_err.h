@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_NO_MEM              0x101
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_NOT_FOUND           0x105
+#define ESP_ERR_NOT_SUPPORTED       0x106
+#define ESP_ERR_TIMEOUT             0x107
+#define ESP_ERR_INVALID_RESPONSE    0x108
+#define ESP_ERR_INVALID_CRC         0x109
+#define ESP_ERR_INVALID_VERSION     0x10A
+
+#define ESP_ERR_NVS_BASE              0x1100
+#define ESP_ERR_NVS_NOT_INITIALIZED   0x1101
+#define ESP_ERR_NVS_NOT_FOUND         0x1102
+#define ESP_ERR_NVS_TYPE_MISMATCH     0x1103
+#define ESP_ERR_NVS_READ_ONLY         0x1104
+#define ESP_ERR_NVS_INVALID_HANDLE    0x1107
+#define ESP_ERR_NVS_INVALID_LENGTH    0x110c
+#define ESP_ERR_NVS_NO_FREE_PAGES     0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND 0x1110
+
+#define ESP_ERR_WIFI_BASE           0x3000
+#define ESP_ERR_WIFI_NOT_INIT       0x3001
+#define ESP_ERR_WIFI_NOT_STARTED    0x3002
+#define ESP_ERR_WIFI_NOT_STOPPED    0x3003
+#define ESP_ERR_WIFI_MODE           0x3005
+#define ESP_ERR_WIFI_STATE          0x3006
+#define ESP_ERR_WIFI_CONN           0x3007
+#define ESP_ERR_WIFI_NOT_CONNECT    0x300F
+
+#define ESP_ERR_HTTPD_BASE          0xb000
+#define ESP_ERR_HTTPD_HANDLERS_FULL 0xb001
+#define ESP_ERR_HTTPD_HANDLER_EXISTS 0xb002
+#define ESP_ERR_HTTPD_INVALID_REQ   0xb003
+#define ESP_ERR_HTTPD_RESULT_TRUNC  0xb004
+#define ESP_ERR_HTTPD_RESP_HDR      0xb005
+#define ESP_ERR_HTTPD_TASK          0xb008
+
+#define ESP_ERR_ESPNOW_BASE         0x3064
+#define ESP_ERR_ESPNOW_NOT_INIT     (ESP_ERR_ESPNOW_BASE + 1)
+#define ESP_ERR_ESPNOW_FULL         (ESP_ERR_ESPNOW_BASE + 4)
+#define ESP_ERR_ESPNOW_NOT_FOUND    (ESP_ERR_ESPNOW_BASE + 5)
+#define ESP_ERR_ESPNOW_EXIST        (ESP_ERR_ESPNOW_BASE + 7)
+
+const char *esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x) do {                                             \
+        esp_err_t err_rc_ = (x);                                            \
+        if (err_rc_ != ESP_OK) {                                            \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: %s (0x%x) at %s:%d: %s\n", \
+                    esp_err_to_name(err_rc_), err_rc_, __FILE__, __LINE__, #x); \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Default event loop, dispatching in the posting task. A handler that
+ * unregisters another during dispatch stops it from being called, as
+ * on the device.
+ */
+
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi_types.h"
+#include "host_fake.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HANDLERS 32
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+typedef struct {
+    unsigned            serial;     /* 0 = free */
+    esp_event_base_t    base;
+    int32_t             id;
+    esp_event_handler_t fn;
+    void               *arg;
+} handler_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static handler_t       s_handlers[MAX_HANDLERS];
+static unsigned        s_serial;
+static bool            s_loop;
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    pthread_mutex_lock(&s_lock);
+    esp_err_t err = s_loop ? ESP_ERR_INVALID_STATE : ESP_OK;
+    s_loop = true;
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+static esp_err_t add(esp_event_base_t base, int32_t id, esp_event_handler_t fn, void *arg,
+                     unsigned *serial)
+{
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_HANDLERS; i++) {
+        if (s_handlers[i].serial == 0) {
+            s_handlers[i] = (handler_t){ ++s_serial, base, id, fn, arg };
+            *serial = s_handlers[i].serial;
+            pthread_mutex_unlock(&s_lock);
+            return ESP_OK;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id,
+                                     esp_event_handler_t handler, void *arg)
+{
+    unsigned serial;
+    return add(base, id, handler, arg, &serial);
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id,
+                                              esp_event_handler_t handler, void *arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    unsigned serial;
+    esp_err_t err = add(base, id, handler, arg, &serial);
+    if (err == ESP_OK && instance) {
+        *instance = (void *)(uintptr_t)serial;
+    }
+    return err;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id,
+                                       esp_event_handler_t handler)
+{
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_HANDLERS; i++) {
+        handler_t *h = &s_handlers[i];
+        if (h->serial && h->base == base && h->id == id && h->fn == handler) {
+            h->serial = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t base, int32_t id,
+                                                esp_event_handler_instance_t instance)
+{
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_HANDLERS; i++) {
+        handler_t *h = &s_handlers[i];
+        if (instance && h->serial == (unsigned)(uintptr_t)instance &&
+            h->base == base && h->id == id) {
+            h->serial = 0;
+            err = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data,
+                         size_t data_size, TickType_t ticks_to_wait)
+{
+    unsigned serials[MAX_HANDLERS];
+    int n = 0;
+
+    pthread_mutex_lock(&s_lock);
+    if (!s_loop) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int i = 0; i < MAX_HANDLERS; i++) {
+        const handler_t *h = &s_handlers[i];
+        if (h->serial && h->base == base && (h->id == ESP_EVENT_ANY_ID || h->id == id)) {
+            serials[n++] = h->serial;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    /* Like the loop task, handlers get a copy */
+    void *copy = NULL;
+    if (data_size > 0) {
+        copy = malloc(data_size);
+        if (!copy) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, data, data_size);
+    }
+
+    for (int k = 0; k < n; k++) {
+        esp_event_handler_t fn = NULL;
+        void *arg = NULL;
+        pthread_mutex_lock(&s_lock);
+        for (int i = 0; i < MAX_HANDLERS; i++) {
+            if (s_handlers[i].serial == serials[k]) {
+                fn  = s_handlers[i].fn;
+                arg = s_handlers[i].arg;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&s_lock);
+        if (fn) {
+            fn(arg, base, id, copy);
+        }
+    }
+
+    free(copy);
+    return ESP_OK;
+}
+
+unsigned host_event_handlers(void)
+{
+    unsigned n = 0;
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_HANDLERS; i++) {
+        n += s_handlers[i].serial != 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
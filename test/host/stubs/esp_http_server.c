@@ -0,0 +1,396 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * HTTP(S) server fake. host_http_request() plays the server task: it
+ * matches the URI against the registered handlers in order and captures
+ * what the handler sends. Queued work runs right away, since requests
+ * and work items are serialised in the server task either way.
+ */
+
+#include "esp_http_server.h"
+#include "esp_https_server.h"
+#include "host_fake.h"
+
+#include "mbedtls/pk.h"
+#include "mbedtls/version.h"
+#include "mbedtls/x509_crt.h"
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#endif
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_SERVERS  4
+#define MAX_REQ_HDRS 16
+
+typedef struct {
+    httpd_config_t cfg;
+    httpd_uri_t   *uris;
+    uint16_t       uri_count;
+    void          *task_stack;  /* stands in for the server task */
+} server_t;
+
+typedef struct {
+    const char       *headers;
+    const char       *body;
+    size_t            body_len;
+    size_t            body_pos;
+    uint16_t          max_hdrs;
+    const char       *status;
+    const char       *type;
+    const char       *hdr_field[MAX_REQ_HDRS];
+    const char       *hdr_value[MAX_REQ_HDRS];
+    uint16_t          hdr_count;
+    bool              sent;
+    host_http_resp_t *resp;
+} fake_req_t;
+
+static server_t *s_servers[MAX_SERVERS];
+
+/* ── Server ─────────────────────────────────────────────────────────── */
+
+bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
+{
+    size_t tpl_len = strlen(template);
+    if (tpl_len > 0 && template[tpl_len - 1] == '*') {
+        return len >= tpl_len - 1 && strncmp(template, uri, tpl_len - 1) == 0;
+    }
+    return len == tpl_len && strncmp(template, uri, len) == 0;
+}
+
+static server_t *find_server(httpd_handle_t handle)
+{
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (s_servers[i] && s_servers[i] == handle) {
+            return s_servers[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    int slot = -1;
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (s_servers[i] && s_servers[i]->cfg.server_port == config->server_port) {
+            return ESP_ERR_HTTPD_TASK; /* port in use */
+        }
+        if (!s_servers[i] && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return ESP_ERR_HTTPD_TASK;
+    }
+
+    server_t *srv = calloc(1, sizeof(*srv));
+    if (!srv) {
+        return ESP_ERR_NO_MEM;
+    }
+    srv->cfg        = *config;
+    srv->uris       = calloc(config->max_uri_handlers, sizeof(*srv->uris));
+    srv->task_stack = malloc(config->stack_size);
+    if (!srv->uris || !srv->task_stack) {
+        free(srv->uris);
+        free(srv->task_stack);
+        free(srv);
+        return ESP_ERR_NO_MEM;
+    }
+    s_servers[slot] = srv;
+    *handle = srv;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (s_servers[i] && s_servers[i] == handle) {
+            server_t *srv = s_servers[i];
+            for (int k = 0; k < srv->uri_count; k++) {
+                free((char *)srv->uris[k].uri);
+            }
+            free(srv->uris);
+            free(srv->task_stack);
+            free(srv);
+            s_servers[i] = NULL;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    server_t *srv = find_server(handle);
+    if (!srv) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < srv->uri_count; i++) {
+        if (srv->uris[i].method == uri_handler->method &&
+            strcmp(srv->uris[i].uri, uri_handler->uri) == 0) {
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (srv->uri_count == srv->cfg.max_uri_handlers) {
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    httpd_uri_t *slot = &srv->uris[srv->uri_count];
+    *slot = *uri_handler;
+    slot->uri = strdup(uri_handler->uri);
+    if (!slot->uri) {
+        return ESP_ERR_NO_MEM;
+    }
+    srv->uri_count++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg)
+{
+    if (!find_server(handle)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    work(arg);
+    return ESP_OK;
+}
+
+unsigned host_httpd_running(void)
+{
+    unsigned n = 0;
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        n += s_servers[i] != NULL;
+    }
+    return n;
+}
+
+/* ── HTTPS ──────────────────────────────────────────────────────────── */
+
+/* Parse what the TLS stack would, so a bad certificate fails on start */
+static esp_err_t check_credentials(const httpd_ssl_config_t *config)
+{
+    mbedtls_x509_crt crt;
+    mbedtls_pk_context pk;
+    mbedtls_x509_crt_init(&crt);
+    mbedtls_pk_init(&pk);
+
+    int ret = mbedtls_x509_crt_parse(&crt, config->servercert, config->servercert_len);
+    if (ret == 0) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+        mbedtls_entropy_context entropy;
+        mbedtls_ctr_drbg_context drbg;
+        mbedtls_entropy_init(&entropy);
+        mbedtls_ctr_drbg_init(&drbg);
+        ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0);
+        if (ret == 0) {
+            ret = mbedtls_pk_parse_key(&pk, config->prvtkey_pem, config->prvtkey_len,
+                                       NULL, 0, mbedtls_ctr_drbg_random, &drbg);
+        }
+        mbedtls_ctr_drbg_free(&drbg);
+        mbedtls_entropy_free(&entropy);
+#else
+        ret = mbedtls_pk_parse_key(&pk, config->prvtkey_pem, config->prvtkey_len, NULL, 0);
+#endif
+    }
+
+    mbedtls_pk_free(&pk);
+    mbedtls_x509_crt_free(&crt);
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_ssl_start(httpd_handle_t *handle, httpd_ssl_config_t *config)
+{
+    esp_err_t err = check_credentials(config);
+    if (err != ESP_OK) {
+        return err;
+    }
+    config->httpd.server_port = config->port_secure;
+    return httpd_start(handle, &config->httpd);
+}
+
+esp_err_t httpd_ssl_stop(httpd_handle_t handle)
+{
+    return httpd_stop(handle);
+}
+
+/* ── Requests ───────────────────────────────────────────────────────── */
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    fake_req_t *fr = r->aux;
+    size_t n = fr->body_len - fr->body_pos;
+    if (n > buf_len) {
+        n = buf_len;
+    }
+    memcpy(buf, fr->body + fr->body_pos, n);
+    fr->body_pos += n;
+    return (int)n;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val,
+                                      size_t val_size)
+{
+    fake_req_t *fr = r->aux;
+    size_t field_len = strlen(field);
+
+    for (const char *line = fr->headers; line && *line; ) {
+        const char *end = strstr(line, "\r\n");
+        if (!end) {
+            end = line + strlen(line);
+        }
+        if (strncasecmp(line, field, field_len) == 0 && line[field_len] == ':') {
+            const char *v = line + field_len + 1;
+            while (*v == ' ') {
+                v++;
+            }
+            size_t len = (size_t)(end - v);
+            if (len >= val_size) {
+                memcpy(val, v, val_size - 1);
+                val[val_size - 1] = '\0';
+                return ESP_ERR_HTTPD_RESULT_TRUNC;
+            }
+            memcpy(val, v, len);
+            val[len] = '\0';
+            return ESP_OK;
+        }
+        line = *end ? end + 2 : end;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    ((fake_req_t *)r->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    ((fake_req_t *)r->aux)->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    fake_req_t *fr = r->aux;
+    if (fr->hdr_count >= fr->max_hdrs || fr->hdr_count >= MAX_REQ_HDRS) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    fr->hdr_field[fr->hdr_count] = field;
+    fr->hdr_value[fr->hdr_count] = value;
+    fr->hdr_count++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    fake_req_t *fr = r->aux;
+    host_http_resp_t *resp = fr->resp;
+    if (fr->sent) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    }
+
+    snprintf(resp->status, sizeof(resp->status), "%s", fr->status ? fr->status : "200 OK");
+    int n = snprintf(resp->headers, sizeof(resp->headers), "Content-Type: %s\r\n",
+                     fr->type ? fr->type : "text/html");
+    for (int i = 0; i < fr->hdr_count && n < (int)sizeof(resp->headers); i++) {
+        n += snprintf(resp->headers + n, sizeof(resp->headers) - n, "%s: %s\r\n",
+                      fr->hdr_field[i], fr->hdr_value[i]);
+    }
+
+    if ((size_t)buf_len > resp->body_cap) {
+        char *body = realloc(resp->body, buf_len);
+        if (!body) {
+            return ESP_ERR_NO_MEM;
+        }
+        resp->body     = body;
+        resp->body_cap = buf_len;
+    }
+    if (buf_len > 0) {
+        memcpy(resp->body, buf, buf_len);
+    }
+    resp->body_len = buf_len;
+    fr->sent = true;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    static const char *const status[] = {
+        [HTTPD_400_BAD_REQUEST]           = "400 Bad Request",
+        [HTTPD_404_NOT_FOUND]             = "404 Not Found",
+        [HTTPD_406_NOT_ACCEPTABLE]        = "406 Not Acceptable",
+        [HTTPD_408_REQ_TIMEOUT]           = "408 Request Timeout",
+        [HTTPD_500_INTERNAL_SERVER_ERROR] = "500 Internal Server Error",
+    };
+    httpd_resp_set_status(req, status[error]);
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_send(req, msg ? msg : status[error], HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t host_http_request(uint16_t port, httpd_method_t method, const char *uri,
+                            const char *headers, const char *body,
+                            host_http_resp_t *resp)
+{
+    server_t *srv = NULL;
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (s_servers[i] && s_servers[i]->cfg.server_port == port) {
+            srv = s_servers[i];
+        }
+    }
+    if (!srv) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    fake_req_t fr = {
+        .headers  = headers,
+        .body     = body,
+        .body_len = body ? strlen(body) : 0,
+        .max_hdrs = srv->cfg.max_resp_headers,
+        .resp     = resp,
+    };
+    httpd_req_t req = {
+        .handle      = srv,
+        .method      = method,
+        .content_len = fr.body_len,
+        .aux         = &fr,
+    };
+    snprintf((char *)req.uri, sizeof(req.uri), "%s", uri);
+    resp->status[0]  = '\0';
+    resp->headers[0] = '\0';
+    resp->body_len   = 0;
+
+    size_t path_len = strcspn(uri, "?");
+    for (int i = 0; i < srv->uri_count; i++) {
+        const httpd_uri_t *h = &srv->uris[i];
+        bool match = srv->cfg.uri_match_fn
+            ? srv->cfg.uri_match_fn(h->uri, uri, path_len)
+            : strlen(h->uri) == path_len && strncmp(h->uri, uri, path_len) == 0;
+        if (h->method == method && match) {
+            req.user_ctx = h->user_ctx;
+            return h->handler(&req);
+        }
+    }
+    return httpd_resp_send_err(&req, HTTPD_404_NOT_FOUND, NULL);
+}
+
+const char *host_http_header(const host_http_resp_t *resp, const char *name,
+                             char *buf, size_t len)
+{
+    fake_req_t fr = { .headers = resp->headers };
+    httpd_req_t req = { .aux = &fr };
+    return httpd_req_get_hdr_value_str(&req, name, buf, len) == ESP_OK ? buf : NULL;
+}
+
+void host_http_resp_free(host_http_resp_t *resp)
+{
+    free(resp->body);
+    memset(resp, 0, sizeof(*resp));
+}
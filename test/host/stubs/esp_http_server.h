@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Server fake without sockets: requests are handed to the registered
+ * handlers by host_http_request(), see host_fake.h. Header and handler
+ * limits behave like the real server.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+    HTTP_DELETE = 0,
+    HTTP_GET    = 1,
+    HTTP_HEAD   = 2,
+    HTTP_POST   = 3,
+} httpd_method_t;
+
+typedef bool (*httpd_uri_match_func_t)(const char *reference_uri,
+                                       const char *uri_to_match, size_t match_upto);
+
+typedef struct {
+    unsigned               task_priority;
+    size_t                 stack_size;
+    uint16_t               server_port;
+    uint16_t               ctrl_port;
+    uint16_t               max_open_sockets;
+    uint16_t               max_uri_handlers;
+    uint16_t               max_resp_headers;
+    bool                   lru_purge_enable;
+    httpd_uri_match_func_t uri_match_fn;
+} httpd_config_t;
+
+#define HTTPD_DEFAULT_CONFIG() {                                            \
+    .task_priority    = 5,                                                  \
+    .stack_size       = 4096,                                               \
+    .server_port      = 80,                                                 \
+    .ctrl_port        = 32768,                                              \
+    .max_open_sockets = 7,                                                  \
+    .max_uri_handlers = 8,                                                  \
+    .max_resp_headers = 8,                                                  \
+    .lru_purge_enable = false,                                              \
+    .uri_match_fn     = NULL,                                               \
+}
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int            method;
+    const char     uri[513];
+    size_t         content_len;
+    void          *aux;
+    void          *user_ctx;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char    *uri;
+    httpd_method_t method;
+    esp_err_t    (*handler)(httpd_req_t *r);
+    void          *user_ctx;
+} httpd_uri_t;
+
+typedef enum {
+    HTTPD_400_BAD_REQUEST,
+    HTTPD_404_NOT_FOUND,
+    HTTPD_406_NOT_ACCEPTABLE,
+    HTTPD_408_REQ_TIMEOUT,
+    HTTPD_500_INTERNAL_SERVER_ERROR,
+} httpd_err_code_t;
+
+#define HTTPD_RESP_USE_STRLEN -1
+
+typedef void (*httpd_work_fn_t)(void *arg);
+
+bool      httpd_uri_match_wildcard(const char *template, const char *uri, size_t len);
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg);
+
+int       httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val,
+                                      size_t val_size);
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status);
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value);
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg);
@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * The certificate and key are parsed with mbedtls on start, so a bad
+ * PEM fails like on the device; requests then go through the fake.
+ */
+
+#pragma once
+
+#include "esp_http_server.h"
+
+typedef struct {
+    httpd_config_t httpd;
+    const uint8_t *servercert;
+    size_t         servercert_len;
+    const uint8_t *prvtkey_pem;
+    size_t         prvtkey_len;
+    uint16_t       port_secure;
+    uint16_t       port_insecure;
+    bool           session_tickets;
+} httpd_ssl_config_t;
+
+#define HTTPD_SSL_CONFIG_DEFAULT() {                                        \
+    .httpd         = HTTPD_DEFAULT_CONFIG(),                                \
+    .port_secure   = 443,                                                   \
+    .port_insecure = 80,                                                    \
+}
+
+esp_err_t httpd_ssl_start(httpd_handle_t *handle, httpd_ssl_config_t *config);
+esp_err_t httpd_ssl_stop(httpd_handle_t handle);
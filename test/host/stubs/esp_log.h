@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Logs go to stderr, filtered by HOST_LOG (E, W, I, D, V; default W).
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+int host_log_level(void);
+
+#define HOST_LOG(level, letter, tag, fmt, ...) do {                         \
+        if (host_log_level() >= (level)) {                                  \
+            fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__);  \
+        }                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(ESP_LOG_ERROR,   "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(ESP_LOG_WARN,    "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(ESP_LOG_INFO,    "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(ESP_LOG_DEBUG,   "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG(ESP_LOG_VERBOSE, "V", tag, fmt, ##__VA_ARGS__)
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif_types.h"
+
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+esp_err_t    esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
+esp_netif_t *esp_netif_create_default_wifi_ap(void);
+void         esp_netif_destroy_default_wifi(void *esp_netif);
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key);
+esp_err_t    esp_netif_get_ip_info(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_info);
+esp_err_t    esp_netif_dhcps_stop(esp_netif_t *esp_netif);
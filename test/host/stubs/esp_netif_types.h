@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) ((ipaddr)->addr >> 0) & 0xff, ((ipaddr)->addr >> 8) & 0xff, \
+                       ((ipaddr)->addr >> 16) & 0xff, ((ipaddr)->addr >> 24) & 0xff
+
+typedef enum {
+    IP_EVENT_STA_GOT_IP,
+    IP_EVENT_STA_LOST_IP,
+} ip_event_t;
+
+typedef struct {
+    int                 if_index;
+    esp_netif_t        *esp_netif;
+    esp_netif_ip_info_t ip_info;
+    bool                ip_changed;
+} ip_event_got_ip_t;
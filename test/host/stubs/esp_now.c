@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * ESP-NOW fake: sent frames go to the test's medium, received frames
+ * are handed in by it (see host_fake.h).
+ */
+
+#include "esp_now.h"
+#include "host_fake.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define MAX_PEERS 20
+
+static bool              s_initialized;
+static uint8_t           s_peers[MAX_PEERS][ESP_NOW_ETH_ALEN];
+static int               s_peer_count;
+static esp_now_recv_cb_t s_recv_cb;
+static host_espnow_tx_t  s_tx;
+
+esp_err_t esp_now_init(void)
+{
+    if (!host_wifi()->started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    s_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+    s_initialized = false;
+    s_recv_cb     = NULL;
+    s_peer_count  = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    s_recv_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    s_recv_cb = NULL;
+    return ESP_OK;
+}
+
+static int find_peer(const uint8_t *addr)
+{
+    for (int i = 0; i < s_peer_count; i++) {
+        if (memcmp(s_peers[i], addr, ESP_NOW_ETH_ALEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (find_peer(peer->peer_addr) >= 0) {
+        return ESP_ERR_ESPNOW_EXIST;
+    }
+    if (s_peer_count == MAX_PEERS) {
+        return ESP_ERR_ESPNOW_FULL;
+    }
+    memcpy(s_peers[s_peer_count++], peer->peer_addr, ESP_NOW_ETH_ALEN);
+    return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    int i = find_peer(peer_addr);
+    if (i < 0) {
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    memmove(s_peers[i], s_peers[i + 1], (size_t)(s_peer_count - i - 1) * ESP_NOW_ETH_ALEN);
+    s_peer_count--;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_get_peer_num(esp_now_peer_num_t *num)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    num->total_num   = s_peer_count;
+    num->encrypt_num = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    if (!s_initialized) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (len > ESP_NOW_MAX_DATA_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_tx) {
+        s_tx(data, len);
+    }
+    return ESP_OK;
+}
+
+void host_espnow_set_tx(host_espnow_tx_t tx)
+{
+    s_tx = tx;
+}
+
+bool host_espnow_rx(const uint8_t *data, size_t len)
+{
+    if (!s_initialized || !s_recv_cb) {
+        return false;
+    }
+    static uint8_t src[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+    esp_now_recv_info_t info = { .src_addr = src };
+    s_recv_cb(&info, data, (int)len);
+    return true;
+}
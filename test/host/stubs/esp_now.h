@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Frames go to and come from a simulated medium, see host_fake.h.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+#define ESP_NOW_ETH_ALEN     6
+#define ESP_NOW_KEY_LEN      16
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef struct {
+    uint8_t *src_addr;
+    uint8_t *des_addr;
+    void    *rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef struct {
+    uint8_t          peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t          lmk[ESP_NOW_KEY_LEN];
+    uint8_t          channel;
+    wifi_interface_t ifidx;
+    bool             encrypt;
+    void            *priv;
+} esp_now_peer_info_t;
+
+typedef struct {
+    int total_num;
+    int encrypt_num;
+} esp_now_peer_num_t;
+
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t *info,
+                                  const uint8_t *data, int data_len);
+
+esp_err_t esp_now_init(void);
+esp_err_t esp_now_deinit(void);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_unregister_recv_cb(void);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr);
+esp_err_t esp_now_get_peer_num(esp_now_peer_num_t *num);
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len);
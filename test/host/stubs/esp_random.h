@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Seeded PRNG so simulations are reproducible, see host_random_seed().
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint32_t esp_random(void);
+void     esp_fill_random(void *buf, size_t len);
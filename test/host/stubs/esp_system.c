@@ -0,0 +1,311 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Clock, heap, randomness, logging and error names for the host fakes.
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "host_fake.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_HEAP_SIZE (64u * 1024 * 1024)
+
+static int s_log_level = ESP_LOG_WARN;
+
+__attribute__((constructor))
+static void host_init(void)
+{
+    const char *level = getenv("HOST_LOG");
+    if (level) {
+        const char *p = strchr("EWIDV", level[0]);
+        s_log_level = p && *p ? (int)(p - "EWIDV") + ESP_LOG_ERROR : ESP_LOG_NONE;
+    }
+}
+
+int host_log_level(void)
+{
+    return s_log_level;
+}
+
+/* ── Clock ──────────────────────────────────────────────────────────── */
+
+static atomic_llong     s_skipped_us;
+static bool             s_skip;
+static host_idle_hook_t s_idle;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + atomic_load(&s_skipped_us);
+}
+
+void host_clock_advance(int64_t us)
+{
+    if (us > 0) {
+        atomic_fetch_add(&s_skipped_us, us);
+    }
+}
+
+void host_clock_skip_waits(bool skip, host_idle_hook_t idle)
+{
+    s_skip = skip;
+    s_idle = idle;
+}
+
+bool host_clock_skipping(void)
+{
+    return s_skip;
+}
+
+/* Let the idle hook deliver something before @p until_us, else jump there */
+bool host_clock_idle(int64_t until_us)
+{
+    if (s_idle && s_idle(until_us)) {
+        return true;
+    }
+    host_clock_advance(until_us - esp_timer_get_time());
+    return false;
+}
+
+/* ── Heap ───────────────────────────────────────────────────────────── */
+
+/* freertos.c */
+void host_tasks_reap(void);
+
+#if defined(__SANITIZE_ADDRESS__)
+
+/* The sanitizer owns malloc; its count is close enough for the budget */
+size_t host_heap_used(void)
+{
+    host_tasks_reap();
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+/* No hook on every allocation here, so the peak is only sampled */
+static size_t s_heap_peak;
+
+size_t host_heap_peak(void)
+{
+    size_t used = host_heap_used();
+    if (used > s_heap_peak) {
+        s_heap_peak = used;
+    }
+    return s_heap_peak;
+}
+
+void host_heap_peak_reset(void)
+{
+    s_heap_peak = host_heap_used();
+}
+
+#else
+
+/*
+ * Every allocation passes through here so the count is exact. mallinfo2()
+ * also counts chunks parked in glibc's per-thread caches, which come and
+ * go with how the fake tasks happen to be scheduled.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+extern void  __libc_free(void *ptr);
+
+static atomic_size_t s_heap_used;
+static atomic_size_t s_heap_peak;
+
+static void *counted(void *ptr)
+{
+    if (ptr) {
+        size_t used = atomic_fetch_add(&s_heap_used, malloc_usable_size(ptr)) +
+                      malloc_usable_size(ptr);
+        size_t peak = atomic_load(&s_heap_peak);
+        while (used > peak && !atomic_compare_exchange_weak(&s_heap_peak, &peak, used)) {
+        }
+    }
+    return ptr;
+}
+
+void *malloc(size_t size)
+{
+    return counted(__libc_malloc(size));
+}
+
+void *calloc(size_t n, size_t size)
+{
+    return counted(__libc_calloc(n, size));
+}
+
+void free(void *ptr)
+{
+    if (ptr) {
+        atomic_fetch_sub(&s_heap_used, malloc_usable_size(ptr));
+        __libc_free(ptr);
+    }
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return malloc(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    size_t old = malloc_usable_size(ptr);
+    void *grown = __libc_realloc(ptr, size);
+    if (grown) {
+        atomic_fetch_sub(&s_heap_used, old);
+        counted(grown);
+    }
+    return grown;
+}
+
+void *memalign(size_t align, size_t size)
+{
+    return counted(__libc_memalign(align, size));
+}
+
+void *aligned_alloc(size_t align, size_t size)
+{
+    return counted(__libc_memalign(align, size));
+}
+
+int posix_memalign(void **out, size_t align, size_t size)
+{
+    if (align % sizeof(void *) != 0 || (align & (align - 1)) != 0) {
+        return EINVAL;
+    }
+    void *ptr = __libc_memalign(align, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = counted(ptr);
+    return 0;
+}
+
+void *valloc(size_t size)
+{
+    return counted(__libc_valloc(size));
+}
+
+void *pvalloc(size_t size)
+{
+    return counted(__libc_pvalloc(size));
+}
+
+size_t host_heap_used(void)
+{
+    host_tasks_reap();
+    return atomic_load(&s_heap_used);
+}
+
+size_t host_heap_peak(void)
+{
+    return atomic_load(&s_heap_peak);
+}
+
+void host_heap_peak_reset(void)
+{
+    atomic_store(&s_heap_peak, host_heap_used());
+}
+
+#endif
+
+uint32_t esp_get_free_heap_size(void)
+{
+    size_t used = host_heap_used();
+    return used < HOST_HEAP_SIZE ? (uint32_t)(HOST_HEAP_SIZE - used) : 0;
+}
+
+/* ── Randomness ─────────────────────────────────────────────────────── */
+
+static pthread_mutex_t s_random_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t        s_random = 0x2545f491;
+
+void host_random_seed(uint32_t seed)
+{
+    pthread_mutex_lock(&s_random_lock);
+    s_random = seed ? seed : 0x2545f491;
+    pthread_mutex_unlock(&s_random_lock);
+}
+
+uint32_t esp_random(void)
+{
+    pthread_mutex_lock(&s_random_lock);
+    uint32_t x = s_random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_random = x;
+    pthread_mutex_unlock(&s_random_lock);
+    return x;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    while (len > 0) {
+        uint32_t r = esp_random();
+        size_t n = len < sizeof(r) ? len : sizeof(r);
+        memcpy(p, &r, n);
+        p   += n;
+        len -= n;
+    }
+}
+
+/* ── Error names ────────────────────────────────────────────────────── */
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                        return "ESP_OK";
+    case ESP_FAIL:                      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:      return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:           return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:       return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_NVS_NOT_INITIALIZED:   return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_TYPE_MISMATCH:     return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_READ_ONLY:         return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_WIFI_NOT_INIT:         return "ESP_ERR_WIFI_NOT_INIT";
+    case ESP_ERR_WIFI_NOT_STARTED:      return "ESP_ERR_WIFI_NOT_STARTED";
+    case ESP_ERR_WIFI_NOT_STOPPED:      return "ESP_ERR_WIFI_NOT_STOPPED";
+    case ESP_ERR_WIFI_MODE:             return "ESP_ERR_WIFI_MODE";
+    case ESP_ERR_WIFI_STATE:            return "ESP_ERR_WIFI_STATE";
+    case ESP_ERR_WIFI_NOT_CONNECT:      return "ESP_ERR_WIFI_NOT_CONNECT";
+    case ESP_ERR_HTTPD_HANDLERS_FULL:   return "ESP_ERR_HTTPD_HANDLERS_FULL";
+    case ESP_ERR_HTTPD_HANDLER_EXISTS:  return "ESP_ERR_HTTPD_HANDLER_EXISTS";
+    case ESP_ERR_HTTPD_RESULT_TRUNC:    return "ESP_ERR_HTTPD_RESULT_TRUNC";
+    case ESP_ERR_HTTPD_RESP_HDR:        return "ESP_ERR_HTTPD_RESP_HDR";
+    case ESP_ERR_HTTPD_TASK:            return "ESP_ERR_HTTPD_TASK";
+    case ESP_ERR_ESPNOW_NOT_INIT:       return "ESP_ERR_ESPNOW_NOT_INIT";
+    default:                            return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Free heap is a fixed budget minus what glibc has handed out, so
+ * differences between two calls are exact.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+uint32_t esp_get_free_heap_size(void);
@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Monotonic time plus whatever the host clock skipped (see host_fake.h).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,613 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * WiFi driver and netif fakes. Connects and scans complete in the
+ * calling task and post their events before returning, against a list
+ * of simulated APs. A raw 64-digit PSK is only accepted by WPA/WPA2
+ * networks; SAE always needs the passphrase.
+ */
+
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "host_fake.h"
+
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
+#include "mbedtls/version.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_APS          64
+#define DRIVER_HEAP      8192    /* what esp_wifi_init() keeps allocated */
+
+typedef struct {
+    host_ap_t ap;
+    char      ssid[33];
+    char      password[65];
+    char      pmk_hex[65];      /* "" if the network takes no raw PSK */
+} sim_ap_t;
+
+static host_wifi_t     s_wifi;
+static sim_ap_t        s_aps[MAX_APS];
+static int             s_ap_count;
+static wifi_config_t   s_sta_cfg;
+static wifi_config_t   s_ap_cfg;
+static const sim_ap_t *s_current;
+static void           *s_driver;
+
+static wifi_ap_record_t *s_results;
+static uint16_t          s_result_count;
+static uint16_t          s_result_pos;
+static bool              s_scanning;
+
+/* nimble.c: with Bluetooth up the coexistence scheme needs modem sleep */
+extern bool host_bt_enabled;
+
+/* ── Simulated networks ─────────────────────────────────────────────── */
+
+static bool takes_pmk(wifi_auth_mode_t authmode)
+{
+    return authmode == WIFI_AUTH_WPA_PSK || authmode == WIFI_AUTH_WPA2_PSK ||
+           authmode == WIFI_AUTH_WPA_WPA2_PSK;
+}
+
+static void derive_pmk(const char *ssid, const char *passphrase, char hex[65])
+{
+    uint8_t pmk[32];
+#if MBEDTLS_VERSION_NUMBER >= 0x03030000
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                  (const unsigned char *)passphrase, strlen(passphrase),
+                  (const unsigned char *)ssid, strlen(ssid), 4096, sizeof(pmk), pmk);
+#else
+    mbedtls_md_context_t md;
+    mbedtls_md_init(&md);
+    int ret = mbedtls_md_setup(&md, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1);
+    if (ret == 0) {
+        ret = mbedtls_pkcs5_pbkdf2_hmac(&md,
+                  (const unsigned char *)passphrase, strlen(passphrase),
+                  (const unsigned char *)ssid, strlen(ssid), 4096, sizeof(pmk), pmk);
+    }
+    mbedtls_md_free(&md);
+#endif
+    if (ret != 0) {
+        abort();
+    }
+    for (int i = 0; i < 32; i++) {
+        sprintf(&hex[i * 2], "%02x", pmk[i]);
+    }
+}
+
+void host_wifi_add_ap(const host_ap_t *ap)
+{
+    if (s_ap_count == MAX_APS) {
+        abort();
+    }
+    sim_ap_t *sim = &s_aps[s_ap_count++];
+    memset(sim, 0, sizeof(*sim));
+    sim->ap = *ap;
+    strncpy(sim->ssid, ap->ssid, sizeof(sim->ssid) - 1);
+    sim->ap.ssid = sim->ssid;
+    if (ap->password) {
+        strncpy(sim->password, ap->password, sizeof(sim->password) - 1);
+        sim->ap.password = sim->password;
+        if (takes_pmk(ap->authmode)) {
+            derive_pmk(sim->ssid, sim->password, sim->pmk_hex);
+        }
+    }
+}
+
+host_wifi_t *host_wifi(void)
+{
+    return &s_wifi;
+}
+
+static void clear_results(void)
+{
+    free(s_results);
+    s_results      = NULL;
+    s_result_count = 0;
+    s_result_pos   = 0;
+}
+
+/* Back to an uninitialised driver and an empty world */
+void host_wifi_reset(void)
+{
+    clear_results();
+    free(s_driver);
+    s_driver   = NULL;
+    s_current  = NULL;
+    s_scanning = false;
+    s_ap_count = 0;
+    memset(&s_wifi, 0, sizeof(s_wifi));
+    memset(&s_sta_cfg, 0, sizeof(s_sta_cfg));
+    memset(&s_ap_cfg, 0, sizeof(s_ap_cfg));
+}
+
+static bool password_matches(const sim_ap_t *sim, const char *password, size_t len)
+{
+    if (sim->ap.authmode == WIFI_AUTH_OPEN) {
+        return true;
+    }
+    if (len == 64) {
+        s_wifi.pmk_connects++;
+        return sim->pmk_hex[0] != '\0' && strncasecmp(password, sim->pmk_hex, 64) == 0;
+    }
+    return strlen(sim->password) == len && memcmp(sim->password, password, len) == 0;
+}
+
+/* The AP the STA config associates with, else the disconnect reason */
+static const sim_ap_t *associate(uint8_t *reason)
+{
+    const wifi_sta_config_t *cfg = &s_sta_cfg.sta;
+    size_t ssid_len = strnlen((const char *)cfg->ssid, sizeof(cfg->ssid));
+    size_t pass_len = strnlen((const char *)cfg->password, sizeof(cfg->password));
+    const sim_ap_t *best = NULL;
+
+    *reason = WIFI_REASON_NO_AP_FOUND;
+    for (int i = 0; i < s_ap_count; i++) {
+        const sim_ap_t *sim = &s_aps[i];
+        if (strlen(sim->ssid) != ssid_len || memcmp(sim->ssid, cfg->ssid, ssid_len) != 0 ||
+            (cfg->bssid_set && memcmp(sim->ap.bssid, cfg->bssid, 6) != 0) ||
+            (cfg->channel && cfg->channel != sim->ap.channel) ||
+            sim->ap.authmode < cfg->threshold.authmode) {
+            continue;
+        }
+        if (!best || sim->ap.rssi > best->ap.rssi) {
+            best = sim;
+        }
+    }
+    if (best && !password_matches(best, (const char *)cfg->password, pass_len)) {
+        *reason = WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT;
+        return NULL;
+    }
+    return best;
+}
+
+/* ── Driver ─────────────────────────────────────────────────────────── */
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    if (s_wifi.initialized) {
+        return ESP_OK;
+    }
+    s_driver = malloc(DRIVER_HEAP);
+    if (!s_driver) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(&s_sta_cfg, 0, sizeof(s_sta_cfg));
+    memset(&s_ap_cfg, 0, sizeof(s_ap_cfg));
+    s_wifi.initialized = true;
+    s_wifi.mode        = WIFI_MODE_STA;
+    s_wifi.ps          = WIFI_PS_MIN_MODEM;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_deinit(void)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (s_wifi.started) {
+        return ESP_ERR_WIFI_NOT_STOPPED;
+    }
+    clear_results();
+    free(s_driver);
+    s_driver = NULL;
+    s_wifi.initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    s_wifi.mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    *mode = s_wifi.mode;
+    return ESP_OK;
+}
+
+static bool has_sta(void)
+{
+    return s_wifi.mode == WIFI_MODE_STA || s_wifi.mode == WIFI_MODE_APSTA;
+}
+
+static bool has_ap(void)
+{
+    return s_wifi.mode == WIFI_MODE_AP || s_wifi.mode == WIFI_MODE_APSTA;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_wifi.started) {
+        s_wifi.started = true;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+    }
+    return ESP_OK;
+}
+
+static void post_disconnected(uint8_t reason)
+{
+    wifi_event_sta_disconnected_t event = {
+        .reason = reason,
+        .rssi   = s_current ? s_current->ap.rssi : 0,
+    };
+    size_t len = strnlen((const char *)s_sta_cfg.sta.ssid, sizeof(event.ssid));
+    memcpy(event.ssid, s_sta_cfg.sta.ssid, len);
+    event.ssid_len = len;
+    if (s_current) {
+        memcpy(event.bssid, s_current->ap.bssid, 6);
+    }
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event), 0);
+}
+
+/* Drop the association, telling the handlers like the driver does */
+static void leave(void)
+{
+    if (s_wifi.associated) {
+        s_wifi.associated = false;
+        post_disconnected(WIFI_REASON_ASSOC_LEAVE);
+        s_current = NULL;
+    }
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (s_wifi.started) {
+        leave();
+        s_scanning     = false;
+        s_wifi.started = false;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (!has_sta()) {
+        return ESP_ERR_WIFI_MODE;
+    }
+
+    s_wifi.connects++;
+    uint8_t reason;
+    const sim_ap_t *ap = associate(&reason);
+    if (!ap) {
+        post_disconnected(reason);
+        return ESP_OK;
+    }
+
+    s_current         = ap;
+    s_wifi.associated = true;
+    s_wifi.channel    = ap->ap.channel;
+
+    wifi_event_sta_connected_t connected = {
+        .channel  = ap->ap.channel,
+        .authmode = ap->ap.authmode,
+        .aid      = 1,
+    };
+    connected.ssid_len = strlen(ap->ssid);
+    memcpy(connected.ssid, ap->ssid, connected.ssid_len);
+    memcpy(connected.bssid, ap->ap.bssid, 6);
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected, sizeof(connected), 0);
+
+    ip_event_got_ip_t got_ip = {
+        .esp_netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"),
+        .ip_info   = {
+            .ip      = { .addr = 0x3201a8c0 },  /* 192.168.1.50 */
+            .netmask = { .addr = 0x00ffffff },
+            .gw      = { .addr = 0x0101a8c0 },
+        },
+    };
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    leave();
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (interface == WIFI_IF_STA ? !has_sta() : !has_ap()) {
+        return ESP_ERR_WIFI_MODE;
+    }
+    *(interface == WIFI_IF_STA ? &s_sta_cfg : &s_ap_cfg) = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (interface == WIFI_IF_STA ? !has_sta() : !has_ap()) {
+        return ESP_ERR_WIFI_MODE;
+    }
+    *conf = interface == WIFI_IF_STA ? s_sta_cfg : s_ap_cfg;
+    return ESP_OK;
+}
+
+/* ── Scanning ───────────────────────────────────────────────────────── */
+
+static void scan_done(void)
+{
+    s_scanning = false;
+    wifi_event_sta_scan_done_t event = {
+        .status = 0,
+        .number = s_result_count > 255 ? 255 : (uint8_t)s_result_count,
+    };
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &event, sizeof(event), 0);
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block)
+{
+    if (!s_wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (!s_wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (!has_sta()) {
+        return ESP_ERR_WIFI_MODE;
+    }
+    if (s_scanning) {
+        return ESP_ERR_WIFI_STATE;
+    }
+
+    clear_results();
+    s_results = calloc(s_ap_count ? s_ap_count : 1, sizeof(*s_results));
+    if (!s_results) {
+        return ESP_ERR_NO_MEM;
+    }
+    bool show_hidden = config && config->show_hidden;
+    for (int i = 0; i < s_ap_count; i++) {
+        const sim_ap_t *sim = &s_aps[i];
+        if (sim->ap.hidden && !show_hidden) {
+            continue;
+        }
+        wifi_ap_record_t *rec = &s_results[s_result_count++];
+        memcpy(rec->bssid, sim->ap.bssid, 6);
+        if (!sim->ap.hidden) {
+            strncpy((char *)rec->ssid, sim->ssid, sizeof(rec->ssid) - 1);
+        }
+        rec->primary  = sim->ap.channel;
+        rec->rssi     = sim->ap.rssi;
+        rec->authmode = sim->ap.authmode;
+    }
+
+    s_wifi.scans++;
+    s_scanning = true;
+    if (!s_wifi.scan_deferred || block) {
+        scan_done();
+    }
+    return ESP_OK;
+}
+
+void host_wifi_finish_scan(void)
+{
+    if (s_scanning) {
+        scan_done();
+    }
+}
+
+esp_err_t esp_wifi_scan_stop(void)
+{
+    s_scanning = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number)
+{
+    *number = s_result_count - s_result_pos;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t *ap_record)
+{
+    if (s_result_pos >= s_result_count) {
+        clear_results();
+        return ESP_FAIL;
+    }
+    *ap_record = s_results[s_result_pos++];
+    if (s_result_pos == s_result_count) {
+        clear_results();
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records)
+{
+    uint16_t n = s_result_count - s_result_pos;
+    if (n > *number) {
+        n = *number;
+    }
+    memcpy(ap_records, s_results + s_result_pos, n * sizeof(*ap_records));
+    *number = n;
+    clear_results();
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void)
+{
+    clear_results();
+    return ESP_OK;
+}
+
+/* ── Link ───────────────────────────────────────────────────────────── */
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    if (!s_wifi.associated || !s_current) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    memset(ap_info, 0, sizeof(*ap_info));
+    memcpy(ap_info->bssid, s_current->ap.bssid, 6);
+    strncpy((char *)ap_info->ssid, s_current->ssid, sizeof(ap_info->ssid) - 1);
+    ap_info->primary  = s_current->ap.channel;
+    ap_info->rssi     = s_current->ap.rssi;
+    ap_info->authmode = s_current->ap.authmode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    s_wifi.set_ps_calls++;
+    if (s_wifi.set_ps_err != ESP_OK) {
+        return s_wifi.set_ps_err;
+    }
+    if (type == WIFI_PS_NONE && host_bt_enabled) {
+        ESP_LOGE("wifi", "Should enable WiFi modem sleep when both WiFi and Bluetooth are enabled");
+        return ESP_FAIL;
+    }
+    s_wifi.ps = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type)
+{
+    *type = s_wifi.ps;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    if (!s_wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (primary < 1 || primary > 14) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_wifi.channel = primary;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_inactive_time(wifi_interface_t ifx, uint16_t sec)
+{
+    return s_wifi.initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_rssi_threshold(int32_t rssi)
+{
+    return s_wifi.initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+}
+
+/* ── Netif ──────────────────────────────────────────────────────────── */
+
+#define MAX_NETIFS 4
+
+struct esp_netif_obj {
+    char    ifkey[16];
+    uint8_t lwip[1024];     /* stands in for the lwIP interface state */
+};
+
+static esp_netif_t *s_netifs[MAX_NETIFS];
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+static esp_netif_t *netif_create(const char *ifkey)
+{
+    if (esp_netif_get_handle_from_ifkey(ifkey)) {
+        fprintf(stderr, "esp_netif: interface %s already exists\n", ifkey);
+        abort();
+    }
+    for (int i = 0; i < MAX_NETIFS; i++) {
+        if (!s_netifs[i]) {
+            s_netifs[i] = calloc(1, sizeof(esp_netif_t));
+            if (!s_netifs[i]) {
+                abort();
+            }
+            strcpy(s_netifs[i]->ifkey, ifkey);
+            return s_netifs[i];
+        }
+    }
+    abort();
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    return netif_create("WIFI_STA_DEF");
+}
+
+esp_netif_t *esp_netif_create_default_wifi_ap(void)
+{
+    return netif_create("WIFI_AP_DEF");
+}
+
+void esp_netif_destroy_default_wifi(void *esp_netif)
+{
+    for (int i = 0; i < MAX_NETIFS; i++) {
+        if (s_netifs[i] && s_netifs[i] == esp_netif) {
+            free(s_netifs[i]);
+            s_netifs[i] = NULL;
+            return;
+        }
+    }
+    fprintf(stderr, "esp_netif: destroying unknown interface %p\n", esp_netif);
+    abort();
+}
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key)
+{
+    for (int i = 0; i < MAX_NETIFS; i++) {
+        if (s_netifs[i] && strcmp(s_netifs[i]->ifkey, if_key) == 0) {
+            return s_netifs[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_info)
+{
+    memset(ip_info, 0, sizeof(*ip_info));
+    if (strcmp(esp_netif->ifkey, "WIFI_AP_DEF") == 0) {
+        ip_info->ip.addr = 0x0104a8c0;          /* 192.168.4.1 */
+    } else if (s_wifi.associated) {
+        ip_info->ip.addr = 0x3201a8c0;
+    }
+    ip_info->netmask.addr = 0x00ffffff;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcps_stop(esp_netif_t *esp_netif)
+{
+    return ESP_OK;
+}
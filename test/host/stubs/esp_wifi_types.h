@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * The subset of ESP-IDF 5.x WiFi types the component uses.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_event.h"
+
+typedef enum {
+    WIFI_MODE_NULL,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_WAPI_PSK,
+    WIFI_AUTH_OWE,
+    WIFI_AUTH_MAX,
+} wifi_auth_mode_t;
+
+typedef enum {
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+typedef enum {
+    WPA3_SAE_PWE_UNSPECIFIED,
+    WPA3_SAE_PWE_HUNT_AND_PECK,
+    WPA3_SAE_PWE_HASH_TO_ELEMENT,
+    WPA3_SAE_PWE_BOTH,
+} wifi_sae_pwe_method_t;
+
+typedef enum {
+    WIFI_SECOND_CHAN_NONE = 0,
+    WIFI_SECOND_CHAN_ABOVE,
+    WIFI_SECOND_CHAN_BELOW,
+} wifi_second_chan_t;
+
+typedef struct {
+    bool capable;
+    bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+    int8_t           rssi;
+    wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+    uint8_t *ssid;
+    uint8_t *bssid;
+    uint8_t  channel;
+    bool     show_hidden;
+} wifi_scan_config_t;
+
+typedef struct {
+    uint8_t            bssid[6];
+    uint8_t            ssid[33];
+    uint8_t            primary;
+    wifi_second_chan_t second;
+    int8_t             rssi;
+    wifi_auth_mode_t   authmode;
+} wifi_ap_record_t;
+
+typedef struct {
+    uint8_t               ssid[32];
+    uint8_t               password[64];
+    uint8_t               ssid_len;
+    uint8_t               channel;
+    wifi_auth_mode_t      authmode;
+    uint8_t               ssid_hidden;
+    uint8_t               max_connection;
+    uint16_t              beacon_interval;
+    wifi_pmf_config_t     pmf_cfg;
+} wifi_ap_config_t;
+
+typedef struct {
+    uint8_t               ssid[32];
+    uint8_t               password[64];
+    bool                  bssid_set;
+    uint8_t               bssid[6];
+    uint8_t               channel;
+    uint16_t              listen_interval;
+    wifi_scan_threshold_t threshold;
+    wifi_pmf_config_t     pmf_cfg;
+    uint32_t              rm_enabled:1;
+    uint32_t              btm_enabled:1;
+    uint32_t              mbo_enabled:1;
+    uint32_t              ft_enabled:1;
+    uint32_t              reserved:28;
+    wifi_sae_pwe_method_t sae_pwe_h2e;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_ap_config_t  ap;
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+    int unused;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+typedef enum {
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_STA_AUTHMODE_CHANGE,
+    WIFI_EVENT_STA_BSS_RSSI_LOW,
+} wifi_event_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE            = 8,
+    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+    WIFI_REASON_NO_AP_FOUND            = 201,
+} wifi_err_reason_t;
+
+typedef struct {
+    uint32_t status;
+    uint8_t  number;
+    uint8_t  scan_id;
+} wifi_event_sta_scan_done_t;
+
+typedef struct {
+    uint8_t          ssid[32];
+    uint8_t          ssid_len;
+    uint8_t          bssid[6];
+    uint8_t          channel;
+    wifi_auth_mode_t authmode;
+    uint16_t         aid;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t  rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef struct {
+    int32_t rssi;
+} wifi_event_bss_rssi_low_t;
@@ -0,0 +1,437 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * FreeRTOS on pthreads. Deleting another task cancels its thread, which
+ * is only safe while it is parked in vTaskSuspend(), the one way the
+ * component ever waits for a deletion.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "host_fake.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* esp_system.c */
+bool host_clock_skipping(void);
+bool host_clock_idle(int64_t until_us);
+
+/* ── Critical sections ──────────────────────────────────────────────── */
+
+static pthread_mutex_t s_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void host_critical_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+/* ── Tasks ──────────────────────────────────────────────────────────── */
+
+struct host_task {
+    pthread_t      thread;
+    TaskFunction_t fn;
+    void          *arg;
+};
+
+void host_tasks_reap(void);
+
+static __thread struct host_task *t_self = NULL;
+static atomic_uint s_tasks;
+
+/* Tasks that deleted themselves, joined and freed by host_tasks_reap() */
+static pthread_mutex_t    s_zombie_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task  *s_zombies[16];
+static int                s_zombie_count;
+
+static void *task_main(void *p)
+{
+    t_self = p;
+    t_self->fn(t_self->arg);
+    fprintf(stderr, "FreeRTOS task returned instead of deleting itself\n");
+    abort();
+}
+
+static struct host_task *task_spawn(TaskFunction_t fn, void *arg)
+{
+    host_tasks_reap();
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (!task) {
+        return NULL;
+    }
+    task->fn  = fn;
+    task->arg = arg;
+    if (pthread_create(&task->thread, NULL, task_main, task) != 0) {
+        free(task);
+        return NULL;
+    }
+    atomic_fetch_add(&s_tasks, 1);
+    return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *created)
+{
+    struct host_task *task = task_spawn(fn, arg);
+    if (created) {
+        *created = task;
+    }
+    return task ? pdPASS : pdFAIL;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                               void *arg, UBaseType_t priority, StackType_t *stack,
+                               StaticTask_t *tcb)
+{
+    return task_spawn(fn, arg);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task || task == t_self) {
+        /* A thread cannot free its own stack: leave that to the reaper */
+        pthread_mutex_lock(&s_zombie_lock);
+        if (s_zombie_count == (int)(sizeof(s_zombies) / sizeof(s_zombies[0]))) {
+            abort();
+        }
+        s_zombies[s_zombie_count++] = t_self;
+        pthread_mutex_unlock(&s_zombie_lock);
+        atomic_fetch_sub(&s_tasks, 1);
+        t_self = NULL;
+        pthread_exit(NULL);
+    }
+
+    pthread_cancel(task->thread);
+    pthread_join(task->thread, NULL);
+    atomic_fetch_sub(&s_tasks, 1);
+    free(task);
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    if (task && task != t_self) {
+        fprintf(stderr, "vTaskSuspend() of another task is not supported\n");
+        abort();
+    }
+    for (;;) {
+        pause(); /* cancellation point for vTaskDelete() */
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (host_clock_skipping()) {
+        int64_t until = esp_timer_get_time() + (int64_t)ticks * 1000;
+        while (host_clock_idle(until)) {
+        }
+        return;
+    }
+    struct timespec ts = {
+        .tv_sec  = ticks / 1000,
+        .tv_nsec = (long)(ticks % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+void host_tasks_reap(void)
+{
+    pthread_mutex_lock(&s_zombie_lock);
+    while (s_zombie_count > 0) {
+        struct host_task *task = s_zombies[--s_zombie_count];
+        pthread_join(task->thread, NULL);
+        free(task);
+    }
+    pthread_mutex_unlock(&s_zombie_lock);
+}
+
+unsigned host_tasks_alive(void)
+{
+    host_tasks_reap();
+    return atomic_load(&s_tasks);
+}
+
+/* ── Wait objects ───────────────────────────────────────────────────── */
+
+typedef bool (*ready_fn_t)(const host_sync_t *s, const void *arg);
+
+static void sync_init(host_sync_t *s, bool is_static)
+{
+    memset(s, 0, sizeof(*s));
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    s->is_static = is_static;
+}
+
+static host_sync_t *sync_new(void)
+{
+    host_sync_t *s = malloc(sizeof(*s));
+    if (s) {
+        sync_init(s, false);
+    }
+    return s;
+}
+
+static void sync_delete(host_sync_t *s)
+{
+    if (!s) {
+        return;
+    }
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s->items);
+    if (!s->is_static) {
+        free(s);
+    }
+}
+
+/* With s->lock held: wait until ready() or the ticks run out */
+static bool sync_wait(host_sync_t *s, ready_fn_t ready, const void *arg, TickType_t ticks)
+{
+    if (ready(s, arg) || ticks == 0) {
+        return ready(s, arg);
+    }
+
+    if (ticks == portMAX_DELAY) {
+        while (!ready(s, arg)) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        return true;
+    }
+
+    if (host_clock_skipping()) {
+        int64_t until = esp_timer_get_time() + (int64_t)ticks * 1000;
+        while (!ready(s, arg)) {
+            pthread_mutex_unlock(&s->lock);
+            bool progress = host_clock_idle(until);
+            pthread_mutex_lock(&s->lock);
+            if (!progress) {
+                break;
+            }
+        }
+        return ready(s, arg);
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec  += ticks / 1000;
+    deadline.tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (!ready(s, arg)) {
+        if (pthread_cond_timedwait(&s->cond, &s->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    return ready(s, arg);
+}
+
+/* ── Semaphores ─────────────────────────────────────────────────────── */
+
+static bool sem_ready(const host_sync_t *s, const void *arg)
+{
+    return s->value > 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    host_sync_t *s = sync_new();
+    if (s) {
+        s->max = 1;
+    }
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    sync_init(buffer, true);
+    buffer->max = 1;
+    return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    host_sync_t *s = xSemaphoreCreateBinary();
+    if (s) {
+        s->value = 1;
+    }
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    pthread_mutex_lock(&sem->lock);
+    bool ok = sync_wait(sem, sem_ready, NULL, ticks);
+    if (ok) {
+        sem->value--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    bool ok = sem->value < sem->max;
+    if (ok) {
+        sem->value++;
+        pthread_cond_broadcast(&sem->cond);
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    sync_delete(sem);
+}
+
+/* ── Event groups ───────────────────────────────────────────────────── */
+
+typedef struct {
+    EventBits_t bits;
+    bool        all;
+} bits_wait_t;
+
+static bool bits_ready(const host_sync_t *s, const void *arg)
+{
+    const bits_wait_t *w = arg;
+    return w->all ? (s->value & w->bits) == w->bits : (s->value & w->bits) != 0;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return sync_new();
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer)
+{
+    sync_init(buffer, true);
+    return buffer;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    sync_delete(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    group->value |= bits;
+    EventBits_t value = group->value;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->value;
+    group->value &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks)
+{
+    bits_wait_t w = { .bits = bits, .all = wait_for_all };
+    pthread_mutex_lock(&group->lock);
+    bool ok = sync_wait(group, bits_ready, &w, ticks);
+    EventBits_t value = group->value;
+    if (ok && clear_on_exit) {
+        group->value &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+/* ── Queues ─────────────────────────────────────────────────────────── */
+
+static bool queue_has_space(const host_sync_t *s, const void *arg)
+{
+    return s->count < s->length;
+}
+
+static bool queue_has_item(const host_sync_t *s, const void *arg)
+{
+    return s->count > 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    host_sync_t *q = sync_new();
+    if (!q) {
+        return NULL;
+    }
+    q->items = malloc((size_t)length * item_size);
+    if (!q->items) {
+        sync_delete(q);
+        return NULL;
+    }
+    q->length    = length;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = sync_wait(queue, queue_has_space, NULL, ticks);
+    if (ok) {
+        size_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok ? pdTRUE : errQUEUE_FULL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = sync_wait(queue, queue_has_item, NULL, ticks);
+    if (ok) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    sync_delete(queue);
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * FreeRTOS on pthreads: tasks are threads, semaphores, event groups
+ * and queues share one mutex/condvar object, and every critical
+ * section takes the same recursive lock. One tick is one millisecond.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint8_t  StackType_t;
+
+#define configTICK_RATE_HZ  1000
+#define portMAX_DELAY       ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTICKS_TO_MS(t)    ((uint32_t)(t))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define errQUEUE_FULL       pdFALSE
+
+#define BIT0 0x01
+#define BIT1 0x02
+#define BIT2 0x04
+#define BIT3 0x08
+
+/* Backs semaphores, event groups and queues; the Static* buffers are one */
+typedef struct host_sync {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        value;      /* semaphore count or event bits */
+    uint32_t        max;        /* semaphore limit */
+    uint8_t        *items;      /* queue storage */
+    size_t          item_size;
+    size_t          length;
+    size_t          head;
+    size_t          count;
+    bool            is_static;
+} host_sync_t;
+
+typedef host_sync_t StaticSemaphore_t;
+typedef host_sync_t StaticEventGroup_t;
+typedef host_sync_t StaticQueue_t;
+
+typedef struct {
+    int unused;
+} StaticTask_t;
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+
+#define portENTER_CRITICAL(mux) ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL(mux)  ((void)(mux), host_critical_exit())
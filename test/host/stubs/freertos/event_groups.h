@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef host_sync_t *EventGroupHandle_t;
+typedef uint32_t     EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer);
+void               vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t        xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                       BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                       TickType_t ticks);
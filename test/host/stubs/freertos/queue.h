@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef host_sync_t *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t    xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t    xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+void          vQueueDelete(QueueHandle_t queue);
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t   xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                         void *arg, UBaseType_t priority, TaskHandle_t *created);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                               void *arg, UBaseType_t priority, StackType_t *stack,
+                               StaticTask_t *tcb);
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskSuspend(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+TickType_t   xTaskGetTickCount(void);
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * The subset of the NimBLE host API the BLE transport uses. GATT
+ * access is driven by host_ble_access(), see host_fake.h. As in NimBLE,
+ * the util helpers are not part of this header (host/util/util.h).
+ */
+
+#pragma once
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct os_mbuf {
+    uint8_t  om_data[512];
+    uint16_t om_len;
+};
+
+#define OS_MBUF_PKTLEN(om) ((om)->om_len)
+
+int os_mbuf_append(struct os_mbuf *om, const void *data, uint16_t len);
+int ble_hs_mbuf_to_flat(const struct os_mbuf *om, void *flat, uint16_t max_len,
+                        uint16_t *out_copy_len);
+
+typedef struct {
+    uint8_t type;
+} ble_uuid_t;
+
+typedef struct {
+    ble_uuid_t u;
+    uint8_t    value[16];
+} ble_uuid128_t;
+
+#define BLE_UUID_TYPE_128 128
+#define BLE_UUID128_INIT(uuid128...) { .u = { .type = BLE_UUID_TYPE_128 }, .value = { uuid128 } }
+
+typedef struct {
+    uint8_t type;
+    uint8_t val[6];
+} ble_addr_t;
+
+/* ── GATT server ────────────────────────────────────────────────────── */
+
+#define BLE_GATT_ACCESS_OP_READ_CHR  0
+#define BLE_GATT_ACCESS_OP_WRITE_CHR 1
+
+#define BLE_GATT_CHR_F_READ      0x0002
+#define BLE_GATT_CHR_F_WRITE     0x0008
+#define BLE_GATT_CHR_F_NOTIFY    0x0010
+#define BLE_GATT_CHR_F_WRITE_ENC 0x1000
+
+#define BLE_GATT_SVC_TYPE_END     0
+#define BLE_GATT_SVC_TYPE_PRIMARY 1
+
+#define BLE_ATT_ERR_WRITE_NOT_PERMITTED    0x03
+#define BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN 0x0d
+#define BLE_ATT_ERR_UNLIKELY               0x0e
+#define BLE_ATT_ERR_INSUFFICIENT_RES       0x11
+
+struct ble_gatt_access_ctxt {
+    uint8_t         op;
+    struct os_mbuf *om;
+};
+
+typedef int ble_gatt_access_fn(uint16_t conn_handle, uint16_t attr_handle,
+                               struct ble_gatt_access_ctxt *ctxt, void *arg);
+
+struct ble_gatt_chr_def {
+    const ble_uuid_t   *uuid;
+    ble_gatt_access_fn *access_cb;
+    void               *arg;
+    void               *descriptors;
+    uint16_t            flags;
+    uint8_t             min_key_size;
+    uint16_t           *val_handle;
+};
+
+struct ble_gatt_svc_def {
+    uint8_t                         type;
+    const ble_uuid_t               *uuid;
+    const struct ble_gatt_svc_def **includes;
+    const struct ble_gatt_chr_def  *characteristics;
+};
+
+int  ble_gatts_count_cfg(const struct ble_gatt_svc_def *defs);
+int  ble_gatts_add_svcs(const struct ble_gatt_svc_def *svcs);
+void ble_gatts_chr_updated(uint16_t chr_val_handle);
+
+/* ── GAP ────────────────────────────────────────────────────────────── */
+
+#define BLE_HS_FOREVER           INT32_MAX
+#define BLE_HS_ADV_F_DISC_GEN    0x02
+#define BLE_HS_ADV_F_BREDR_UNSUP 0x04
+#define BLE_HS_IO_NO_INPUT_OUTPUT 0x03
+
+#define BLE_GAP_CONN_MODE_UND 2
+#define BLE_GAP_DISC_MODE_GEN 2
+
+#define BLE_GAP_EVENT_CONNECT        0
+#define BLE_GAP_EVENT_DISCONNECT     1
+#define BLE_GAP_EVENT_ADV_COMPLETE   9
+#define BLE_GAP_EVENT_REPEAT_PAIRING 17
+
+#define BLE_GAP_REPEAT_PAIRING_RETRY 1
+
+struct ble_gap_conn_desc {
+    uint16_t   conn_handle;
+    ble_addr_t peer_id_addr;
+};
+
+struct ble_gap_event {
+    uint8_t type;
+    union {
+        struct {
+            int      status;
+            uint16_t conn_handle;
+        } connect;
+        struct {
+            int                      reason;
+            struct ble_gap_conn_desc conn;
+        } disconnect;
+        struct {
+            uint16_t conn_handle;
+        } repeat_pairing;
+    };
+};
+
+typedef int ble_gap_event_fn(struct ble_gap_event *event, void *arg);
+
+struct ble_hs_adv_fields {
+    uint8_t              flags;
+    const ble_uuid128_t *uuids128;
+    uint8_t              num_uuids128;
+    unsigned             uuids128_is_complete:1;
+};
+
+struct ble_gap_adv_params {
+    uint8_t conn_mode;
+    uint8_t disc_mode;
+};
+
+int ble_gap_adv_set_fields(const struct ble_hs_adv_fields *adv_fields);
+int ble_gap_adv_start(uint8_t own_addr_type, const ble_addr_t *direct_addr,
+                      int32_t duration_ms, const struct ble_gap_adv_params *adv_params,
+                      ble_gap_event_fn *cb, void *cb_arg);
+int ble_gap_conn_find(uint16_t handle, struct ble_gap_conn_desc *out_desc);
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type);
+
+/* ── Host configuration and store ───────────────────────────────────── */
+
+struct ble_store_status_event;
+typedef int ble_store_status_fn(struct ble_store_status_event *event, void *arg);
+
+struct ble_hs_cfg {
+    void               (*sync_cb)(void);
+    ble_store_status_fn *store_status_cb;
+    uint8_t              sm_io_cap;
+    unsigned             sm_bonding:1;
+    unsigned             sm_mitm:1;
+    unsigned             sm_sc:1;
+};
+
+extern struct ble_hs_cfg ble_hs_cfg;
+
+int ble_store_util_delete_peer(const ble_addr_t *peer_id_addr);
+int ble_store_util_status_rr(struct ble_store_status_event *event, void *arg);
@@ -0,0 +1,8 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+int ble_hs_util_ensure_addr(int prefer_random);
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Control side of the host fakes: set up the simulated world (APs,
+ * flash, clients) and look at what the component did with it.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include "esp_http_server.h"
+#include "host/ble_hs.h"
+
+/* ── Clock ──────────────────────────────────────────────────────────── */
+
+/*
+ * Called when every task that could make progress waits with a timeout
+ * while waits are skipped. Returns true if it delivered something
+ * (and advanced the clock to when it happened), false to let the clock
+ * jump to @p until_us.
+ */
+typedef bool (*host_idle_hook_t)(int64_t until_us);
+
+/* Timed waits and delays move the clock instead of sleeping */
+void host_clock_skip_waits(bool skip, host_idle_hook_t idle);
+void host_clock_advance(int64_t us);
+
+/* ── Heap, tasks, randomness ────────────────────────────────────────── */
+
+size_t   host_heap_used(void);
+/* Most heap in use since the last reset (the high-water mark) */
+size_t   host_heap_peak(void);
+void     host_heap_peak_reset(void);
+unsigned host_tasks_alive(void);
+void     host_random_seed(uint32_t seed);
+
+/* ── Events ─────────────────────────────────────────────────────────── */
+
+unsigned host_event_handlers(void);
+
+/* ── NVS ────────────────────────────────────────────────────────────── */
+
+void host_nvs_reset(void);
+bool host_nvs_has(const char *ns, const char *key);
+
+/* ── WiFi driver ────────────────────────────────────────────────────── */
+
+typedef struct {
+    const char      *ssid;
+    uint8_t          bssid[6];
+    uint8_t          channel;
+    int8_t           rssi;
+    wifi_auth_mode_t authmode;
+    const char      *password;  /* NULL for open networks */
+    bool             hidden;    /* SSID not broadcast */
+} host_ap_t;
+
+typedef struct {
+    bool           initialized;
+    bool           started;
+    bool           associated;
+    wifi_mode_t    mode;
+    uint8_t        channel;
+    unsigned       connects;       /* association attempts */
+    unsigned       pmk_connects;   /* ... made with a raw 64-digit PSK */
+    unsigned       scans;
+    unsigned       set_ps_calls;
+    wifi_ps_type_t ps;             /* last applied power save mode */
+    esp_err_t      set_ps_err;     /* injected result of esp_wifi_set_ps() */
+    bool           scan_deferred;  /* scans finish on host_wifi_finish_scan() */
+} host_wifi_t;
+
+host_wifi_t *host_wifi(void);
+void         host_wifi_reset(void);
+void         host_wifi_add_ap(const host_ap_t *ap);
+void         host_wifi_finish_scan(void);
+
+/* ── HTTP server ────────────────────────────────────────────────────── */
+
+typedef struct {
+    char    status[40];      /* "200 OK" */
+    char    headers[512];    /* "Name: value\r\n" … */
+    char   *body;
+    size_t  body_len;
+    size_t  body_cap;
+} host_http_resp_t;
+
+/* @p headers as "Name: value\r\n" lines, may be NULL; @p resp is reused */
+esp_err_t   host_http_request(uint16_t port, httpd_method_t method, const char *uri,
+                              const char *headers, const char *body,
+                              host_http_resp_t *resp);
+const char *host_http_header(const host_http_resp_t *resp, const char *name,
+                             char *buf, size_t len);
+void        host_http_resp_free(host_http_resp_t *resp);
+unsigned    host_httpd_running(void);
+
+/* ── UDP sockets ────────────────────────────────────────────────────── */
+
+/* Send a datagram to the socket bound to @p port, wait for its reply */
+int      host_udp_request(uint16_t port, const void *data, size_t len,
+                          void *reply, size_t cap, int timeout_ms);
+unsigned host_sockets_open(void);
+
+/* ── ESP-NOW ────────────────────────────────────────────────────────── */
+
+typedef void (*host_espnow_tx_t)(const uint8_t *data, size_t len);
+
+void host_espnow_set_tx(host_espnow_tx_t tx);
+/* Hand a received frame to the registered callback; false if none */
+bool host_espnow_rx(const uint8_t *data, size_t len);
+
+/* ── BLE ────────────────────────────────────────────────────────────── */
+
+/* Read or write a registered characteristic as a connected client would */
+int      host_ble_access(const ble_uuid128_t *uuid, uint8_t op, const void *data,
+                         uint16_t len, void *out, uint16_t *out_len);
+bool     host_ble_running(void);
+unsigned host_ble_notifications(void);
@@ -0,0 +1,30 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * In-process UDP sockets: datagrams are injected and replies captured
+ * through host_fake.h. Names are mapped like LWIP_POSIX_SOCKETS_IO_NAMES.
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int     lwip_socket(int domain, int type, int protocol);
+int     lwip_bind(int s, const struct sockaddr *name, socklen_t namelen);
+ssize_t lwip_recvfrom(int s, void *mem, size_t len, int flags,
+                      struct sockaddr *from, socklen_t *fromlen);
+ssize_t lwip_sendto(int s, const void *data, size_t size, int flags,
+                    const struct sockaddr *to, socklen_t tolen);
+int     lwip_shutdown(int s, int how);
+int     lwip_close(int s);
+
+#define socket(domain, type, protocol)         lwip_socket(domain, type, protocol)
+#define bind(s, name, namelen)                 lwip_bind(s, name, namelen)
+#define recvfrom(s, mem, len, flags, from, fl) lwip_recvfrom(s, mem, len, flags, from, fl)
+#define sendto(s, data, size, flags, to, tl)   lwip_sendto(s, data, size, flags, to, tl)
+#define shutdown(s, how)                       lwip_shutdown(s, how)
+#define close(s)                               lwip_close(s)
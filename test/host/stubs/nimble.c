@@ -0,0 +1,274 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * NimBLE host fake. The host task runs nimble_port_run() until
+ * nimble_port_stop(), GATT access comes from host_ble_access() as if a
+ * connected client read or wrote a characteristic.
+ */
+
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#include "host_fake.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SVCS       4
+#define HOST_HEAP      6144     /* what nimble_port_init() keeps allocated */
+#define BLE_HS_EMSGSIZE 4
+#define BLE_HS_ENOMEM   6
+
+struct ble_hs_cfg ble_hs_cfg;
+
+/* Read by the WiFi fake: coexistence refuses WIFI_PS_NONE */
+bool host_bt_enabled;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_cond = PTHREAD_COND_INITIALIZER;
+static void           *s_host_mem;
+static TaskHandle_t    s_host_task;
+static bool            s_stop;
+static bool            s_running;
+static unsigned        s_notifications;
+static uint16_t        s_next_handle;
+
+static const struct ble_gatt_svc_def *s_svcs[MAX_SVCS];
+static int                            s_svc_count;
+
+/* ── Port ───────────────────────────────────────────────────────────── */
+
+esp_err_t nimble_port_init(void)
+{
+    if (s_host_mem) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_host_mem = malloc(HOST_HEAP);
+    if (!s_host_mem) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(&ble_hs_cfg, 0, sizeof(ble_hs_cfg));
+    s_svc_count     = 0;
+    s_next_handle   = 0;
+    host_bt_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t nimble_port_deinit(void)
+{
+    free(s_host_mem);
+    s_host_mem      = NULL;
+    s_svc_count     = 0;
+    host_bt_enabled = false;
+    return ESP_OK;
+}
+
+void nimble_port_freertos_init(TaskFunction_t host_task_fn)
+{
+    pthread_mutex_lock(&s_lock);
+    s_stop = false;
+    pthread_mutex_unlock(&s_lock);
+    xTaskCreate(host_task_fn, "nimble_host", 4096, NULL, 5, &s_host_task);
+}
+
+/* Called by the host task itself once nimble_port_run() returned */
+void nimble_port_freertos_deinit(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_host_task = NULL;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+    vTaskDelete(NULL);
+}
+
+void nimble_port_run(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_running = true;
+    pthread_mutex_unlock(&s_lock);
+
+    if (ble_hs_cfg.sync_cb) {
+        ble_hs_cfg.sync_cb();
+    }
+
+    pthread_mutex_lock(&s_lock);
+    while (!s_stop) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    s_running = false;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+int nimble_port_stop(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (!s_host_task) {
+        pthread_mutex_unlock(&s_lock);
+        return -1;
+    }
+    s_stop = true;
+    pthread_cond_broadcast(&s_cond);
+    while (s_host_task) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return 0;
+}
+
+bool host_ble_running(void)
+{
+    pthread_mutex_lock(&s_lock);
+    bool running = s_running;
+    pthread_mutex_unlock(&s_lock);
+    return running;
+}
+
+/* ── Services ───────────────────────────────────────────────────────── */
+
+void ble_svc_gap_init(void)
+{
+}
+
+void ble_svc_gatt_init(void)
+{
+}
+
+int ble_svc_gap_device_name_set(const char *name)
+{
+    return strlen(name) <= 31 ? 0 : BLE_HS_EMSGSIZE;
+}
+
+int ble_gatts_count_cfg(const struct ble_gatt_svc_def *defs)
+{
+    return s_host_mem ? 0 : BLE_HS_ENOMEM;
+}
+
+int ble_gatts_add_svcs(const struct ble_gatt_svc_def *svcs)
+{
+    if (s_svc_count == MAX_SVCS) {
+        return BLE_HS_ENOMEM;
+    }
+    s_svcs[s_svc_count++] = svcs;
+    for (const struct ble_gatt_svc_def *svc = svcs; svc->type; svc++) {
+        s_next_handle++;
+        for (const struct ble_gatt_chr_def *chr = svc->characteristics; chr->uuid; chr++) {
+            s_next_handle += 2;
+            if (chr->val_handle) {
+                *chr->val_handle = s_next_handle;
+            }
+        }
+    }
+    return 0;
+}
+
+void ble_gatts_chr_updated(uint16_t chr_val_handle)
+{
+    __atomic_add_fetch(&s_notifications, 1, __ATOMIC_RELAXED);
+}
+
+unsigned host_ble_notifications(void)
+{
+    return __atomic_load_n(&s_notifications, __ATOMIC_RELAXED);
+}
+
+/* ── GATT access ────────────────────────────────────────────────────── */
+
+int os_mbuf_append(struct os_mbuf *om, const void *data, uint16_t len)
+{
+    if (om->om_len + len > sizeof(om->om_data)) {
+        return BLE_HS_ENOMEM;
+    }
+    memcpy(om->om_data + om->om_len, data, len);
+    om->om_len += len;
+    return 0;
+}
+
+int ble_hs_mbuf_to_flat(const struct os_mbuf *om, void *flat, uint16_t max_len,
+                        uint16_t *out_copy_len)
+{
+    uint16_t n = om->om_len < max_len ? om->om_len : max_len;
+    memcpy(flat, om->om_data, n);
+    if (out_copy_len) {
+        *out_copy_len = n;
+    }
+    return n < om->om_len ? BLE_HS_EMSGSIZE : 0;
+}
+
+int host_ble_access(const ble_uuid128_t *uuid, uint8_t op, const void *data,
+                    uint16_t len, void *out, uint16_t *out_len)
+{
+    if (!host_ble_running()) {
+        return -1;
+    }
+    for (int s = 0; s < s_svc_count; s++) {
+        for (const struct ble_gatt_svc_def *svc = s_svcs[s]; svc->type; svc++) {
+            for (const struct ble_gatt_chr_def *chr = svc->characteristics; chr->uuid; chr++) {
+                const ble_uuid128_t *u = (const ble_uuid128_t *)chr->uuid;
+                if (u->u.type != uuid->u.type || memcmp(u->value, uuid->value, 16) != 0) {
+                    continue;
+                }
+                struct os_mbuf om = { .om_len = 0 };
+                if (op == BLE_GATT_ACCESS_OP_WRITE_CHR && os_mbuf_append(&om, data, len) != 0) {
+                    return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+                }
+                struct ble_gatt_access_ctxt ctxt = { .op = op, .om = &om };
+                int rc = chr->access_cb(1, 0, &ctxt, chr->arg);
+                if (rc == 0 && op == BLE_GATT_ACCESS_OP_READ_CHR && out && out_len) {
+                    uint16_t n = om.om_len < *out_len ? om.om_len : *out_len;
+                    memcpy(out, om.om_data, n);
+                    *out_len = n;
+                }
+                return rc;
+            }
+        }
+    }
+    return -1;
+}
+
+/* ── GAP and store ──────────────────────────────────────────────────── */
+
+int ble_gap_adv_set_fields(const struct ble_hs_adv_fields *adv_fields)
+{
+    return 0;
+}
+
+int ble_gap_adv_start(uint8_t own_addr_type, const ble_addr_t *direct_addr,
+                      int32_t duration_ms, const struct ble_gap_adv_params *adv_params,
+                      ble_gap_event_fn *cb, void *cb_arg)
+{
+    return 0;
+}
+
+int ble_gap_conn_find(uint16_t handle, struct ble_gap_conn_desc *out_desc)
+{
+    memset(out_desc, 0, sizeof(*out_desc));
+    out_desc->conn_handle = handle;
+    return 0;
+}
+
+int ble_hs_id_infer_auto(int privacy, uint8_t *out_addr_type)
+{
+    *out_addr_type = 0;
+    return 0;
+}
+
+int ble_hs_util_ensure_addr(int prefer_random)
+{
+    return 0;
+}
+
+int ble_store_util_delete_peer(const ble_addr_t *peer_id_addr)
+{
+    return 0;
+}
+
+int ble_store_util_status_rr(struct ble_store_status_event *event, void *arg)
+{
+    return 0;
+}
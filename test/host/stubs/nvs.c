@@ -0,0 +1,293 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * In-memory NVS. A namespace exists once it was opened read-write, as
+ * on flash; opening a missing one read-only fails with NOT_FOUND.
+ */
+
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "host_fake.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NAMESPACES 8
+#define MAX_HANDLES    8
+#define NAME_MAX_LEN   15
+
+typedef enum {
+    TYPE_U8,
+    TYPE_STR,
+    TYPE_BLOB,
+} entry_type_t;
+
+typedef struct entry {
+    struct entry *next;
+    int           ns;
+    char          key[NAME_MAX_LEN + 1];
+    entry_type_t  type;
+    size_t        len;
+    uint8_t       data[];
+} entry_t;
+
+typedef struct {
+    bool            used;
+    int             ns;
+    nvs_open_mode_t mode;
+} handle_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool            s_initialized;
+static char            s_namespaces[MAX_NAMESPACES][NAME_MAX_LEN + 1];
+static entry_t        *s_entries;
+static handle_t        s_handles[MAX_HANDLES];
+
+static void erase_where(int ns)
+{
+    entry_t **pp = &s_entries;
+    while (*pp) {
+        entry_t *e = *pp;
+        if (ns < 0 || e->ns == ns) {
+            *pp = e->next;
+            free(e);
+        } else {
+            pp = &e->next;
+        }
+    }
+}
+
+static int find_namespace(const char *name)
+{
+    for (int i = 0; i < MAX_NAMESPACES; i++) {
+        if (s_namespaces[i][0] && strcmp(s_namespaces[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static entry_t **find_entry(int ns, const char *key)
+{
+    for (entry_t **pp = &s_entries; *pp; pp = &(*pp)->next) {
+        if ((*pp)->ns == ns && strcmp((*pp)->key, key) == 0) {
+            return pp;
+        }
+    }
+    return NULL;
+}
+
+static handle_t *get_handle(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > MAX_HANDLES || !s_handles[handle - 1].used) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+/* ── Flash ──────────────────────────────────────────────────────────── */
+
+esp_err_t nvs_flash_init(void)
+{
+    s_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    host_nvs_reset();
+    return ESP_OK;
+}
+
+void host_nvs_reset(void)
+{
+    pthread_mutex_lock(&s_lock);
+    erase_where(-1);
+    memset(s_namespaces, 0, sizeof(s_namespaces));
+    pthread_mutex_unlock(&s_lock);
+}
+
+bool host_nvs_has(const char *ns, const char *key)
+{
+    pthread_mutex_lock(&s_lock);
+    int index = find_namespace(ns);
+    bool found = index >= 0 && find_entry(index, key) != NULL;
+    pthread_mutex_unlock(&s_lock);
+    return found;
+}
+
+/* ── Handles ────────────────────────────────────────────────────────── */
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (!s_initialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (strlen(name) > NAME_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    int ns = find_namespace(name);
+    if (ns < 0 && open_mode == NVS_READONLY) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (ns < 0) {
+        for (int i = 0; i < MAX_NAMESPACES && ns < 0; i++) {
+            if (!s_namespaces[i][0]) {
+                strcpy(s_namespaces[i], name);
+                ns = i;
+            }
+        }
+        err = ns < 0 ? ESP_ERR_NVS_NO_FREE_PAGES : ESP_OK;
+    }
+    if (err == ESP_OK) {
+        err = ESP_ERR_NO_MEM;
+        for (int i = 0; i < MAX_HANDLES; i++) {
+            if (!s_handles[i].used) {
+                s_handles[i] = (handle_t){ true, ns, open_mode };
+                *out_handle  = i + 1;
+                err = ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_lock);
+    handle_t *h = get_handle(handle);
+    if (h) {
+        h->used = false;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return get_handle(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+/* ── Values ─────────────────────────────────────────────────────────── */
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, entry_type_t type,
+                           const void *value, size_t len)
+{
+    if (strlen(key) > NAME_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    handle_t *h = get_handle(handle);
+    esp_err_t err = !h ? ESP_ERR_NVS_INVALID_HANDLE
+                  : h->mode == NVS_READONLY ? ESP_ERR_NVS_READ_ONLY : ESP_OK;
+    entry_t *e = NULL;
+    if (err == ESP_OK) {
+        e = malloc(sizeof(*e) + len);
+        err = e ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    if (err == ESP_OK) {
+        entry_t **old = find_entry(h->ns, key);
+        if (old) {
+            entry_t *gone = *old;
+            *old = gone->next;
+            free(gone);
+        }
+        e->ns   = h->ns;
+        e->type = type;
+        e->len  = len;
+        strcpy(e->key, key);
+        memcpy(e->data, value, len);
+        e->next   = s_entries;
+        s_entries = e;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+static esp_err_t get_value(nvs_handle_t handle, const char *key, entry_type_t type,
+                           void *out, size_t *length)
+{
+    pthread_mutex_lock(&s_lock);
+    handle_t *h = get_handle(handle);
+    entry_t **pp = h ? find_entry(h->ns, key) : NULL;
+    esp_err_t err = !h ? ESP_ERR_NVS_INVALID_HANDLE
+                  : !pp || (*pp)->type != type ? ESP_ERR_NVS_NOT_FOUND : ESP_OK;
+    if (err == ESP_OK) {
+        const entry_t *e = *pp;
+        if (out && *length < e->len) {
+            err = ESP_ERR_NVS_INVALID_LENGTH;
+        } else if (out) {
+            memcpy(out, e->data, e->len);
+        }
+        *length = e->len;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return set_value(handle, key, TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    return get_value(handle, key, TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set_value(handle, key, TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return get_value(handle, key, TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set_value(handle, key, TYPE_U8, &value, 1);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    size_t len = 1;
+    return get_value(handle, key, TYPE_U8, out_value, &len);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    pthread_mutex_lock(&s_lock);
+    handle_t *h = get_handle(handle);
+    entry_t **pp = h ? find_entry(h->ns, key) : NULL;
+    esp_err_t err = !h ? ESP_ERR_NVS_INVALID_HANDLE
+                  : h->mode == NVS_READONLY ? ESP_ERR_NVS_READ_ONLY
+                  : !pp ? ESP_ERR_NVS_NOT_FOUND : ESP_OK;
+    if (err == ESP_OK) {
+        entry_t *gone = *pp;
+        *pp = gone->next;
+        free(gone);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_lock);
+    handle_t *h = get_handle(handle);
+    esp_err_t err = !h ? ESP_ERR_NVS_INVALID_HANDLE
+                  : h->mode == NVS_READONLY ? ESP_ERR_NVS_READ_ONLY : ESP_OK;
+    if (err == ESP_OK) {
+        erase_where(h->ns);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
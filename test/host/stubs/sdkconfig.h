@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Kconfig defaults for the host build. Boolean options are off unless
+ * the build variant defines them (see CMakeLists.txt).
+ */
+
+#pragma once
+
+#define CONFIG_WIFI_PROV_AP_SSID              "ESP-Provision"
+#define CONFIG_WIFI_PROV_AP_PASSWORD          ""
+#define CONFIG_WIFI_PROV_AP_CHANNEL           0
+#define CONFIG_WIFI_PROV_AP_MAX_CONNECTIONS   4
+#define CONFIG_WIFI_PROV_STA_MAX_RETRIES      5
+#define CONFIG_WIFI_PROV_STA_MIN_AUTHMODE     0
+#define CONFIG_WIFI_PROV_STA_PS_MODE          1
+#define CONFIG_WIFI_PROV_STA_LISTEN_INTERVAL  3
+#define CONFIG_WIFI_PROV_AP_BEACON_INTERVAL   100
+#define CONFIG_WIFI_PROV_AP_INACTIVE_TIME     300
+#define CONFIG_WIFI_PROV_SCAN_CACHE_SIZE      32
+#define CONFIG_WIFI_PROV_PORTAL_TIMEOUT       180
+#define CONFIG_WIFI_PROV_HTTP_PORT            80
+#define CONFIG_WIFI_PROV_HTTPS_PORT           443
+#define CONFIG_WIFI_PROV_ARENA_SIZE           12288
+#define CONFIG_WIFI_PROV_STATS_EVENTS         64
+#define CONFIG_WIFI_PROV_ESPNOW_LISTEN_MS     6000
+#ifndef CONFIG_WIFI_PROV_ESPNOW_KEY
+#define CONFIG_WIFI_PROV_ESPNOW_KEY           "host-test-site-key"
+#endif
+#define CONFIG_WIFI_PROV_PAGE_TITLE           "WiFi Setup"
+#define CONFIG_WIFI_PROV_PORTAL_HEADER        "WiFi Setup"
+#define CONFIG_WIFI_PROV_PORTAL_SUBHEADER     "Please connect to your WiFi network."
+#define CONFIG_WIFI_PROV_CONNECTED_HEADER     "Connected!"
+#define CONFIG_WIFI_PROV_CONNECTED_SUBHEADER  "You are now connected to the network. You can close this page."
+#define CONFIG_WIFI_PROV_PAGE_FOOTER          "&copy; 2026"
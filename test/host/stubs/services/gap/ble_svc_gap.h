@@ -0,0 +1,9 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+void ble_svc_gap_init(void);
+int  ble_svc_gap_device_name_set(const char *name);
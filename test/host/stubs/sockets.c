@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * In-process UDP sockets with a one-datagram mailbox each way. Closing
+ * or shutting down a socket wakes a blocked recvfrom() with an error,
+ * as lwIP does.
+ */
+
+#include "lwip/sockets.h"
+#include "host_fake.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SOCKETS 4
+#define FD_BASE     60      /* lwIP numbers its sockets from LWIP_SOCKET_OFFSET */
+#define DGRAM_MAX   512
+
+typedef struct {
+    bool     used;
+    bool     closed;
+    uint16_t port;
+    uint8_t  rx[DGRAM_MAX];
+    size_t   rx_len;
+    bool     rx_full;
+    uint8_t  tx[DGRAM_MAX];
+    size_t   tx_len;
+    bool     tx_ready;
+} sock_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_cond = PTHREAD_COND_INITIALIZER;
+static sock_t          s_socks[MAX_SOCKETS];
+
+static sock_t *get_sock(int s)
+{
+    int i = s - FD_BASE;
+    return i >= 0 && i < MAX_SOCKETS && s_socks[i].used ? &s_socks[i] : NULL;
+}
+
+int lwip_socket(int domain, int type, int protocol)
+{
+    if (type != SOCK_DGRAM) {
+        errno = EPROTONOSUPPORT;
+        return -1;
+    }
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_SOCKETS; i++) {
+        if (!s_socks[i].used) {
+            memset(&s_socks[i], 0, sizeof(s_socks[i]));
+            s_socks[i].used = true;
+            pthread_mutex_unlock(&s_lock);
+            return FD_BASE + i;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    errno = ENFILE;
+    return -1;
+}
+
+int lwip_bind(int s, const struct sockaddr *name, socklen_t namelen)
+{
+    const struct sockaddr_in *addr = (const struct sockaddr_in *)name;
+    uint16_t port = ntohs(addr->sin_port);
+    int ret = 0;
+
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = get_sock(s);
+    for (int i = 0; sock && i < MAX_SOCKETS; i++) {
+        if (s_socks[i].used && &s_socks[i] != sock && s_socks[i].port == port) {
+            sock = NULL;
+        }
+    }
+    if (sock) {
+        sock->port = port;
+    } else {
+        errno = EADDRINUSE;
+        ret = -1;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+ssize_t lwip_recvfrom(int s, void *mem, size_t len, int flags,
+                      struct sockaddr *from, socklen_t *fromlen)
+{
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = get_sock(s);
+    while (sock && !sock->closed && !sock->rx_full) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    if (!sock || sock->closed) {
+        pthread_mutex_unlock(&s_lock);
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t n = sock->rx_len < len ? sock->rx_len : len;
+    memcpy(mem, sock->rx, n);
+    sock->rx_full = false;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+
+    if (from && fromlen && *fromlen >= sizeof(struct sockaddr_in)) {
+        struct sockaddr_in client = {
+            .sin_family      = AF_INET,
+            .sin_port        = htons(49152),
+            .sin_addr.s_addr = htonl(0xC0A80402),   /* 192.168.4.2 */
+        };
+        memcpy(from, &client, sizeof(client));
+        *fromlen = sizeof(client);
+    }
+    return (ssize_t)n;
+}
+
+ssize_t lwip_sendto(int s, const void *data, size_t size, int flags,
+                    const struct sockaddr *to, socklen_t tolen)
+{
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = get_sock(s);
+    if (!sock || sock->closed || size > DGRAM_MAX) {
+        pthread_mutex_unlock(&s_lock);
+        errno = sock ? EMSGSIZE : EBADF;
+        return -1;
+    }
+    memcpy(sock->tx, data, size);
+    sock->tx_len   = size;
+    sock->tx_ready = true;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+    return (ssize_t)size;
+}
+
+int lwip_shutdown(int s, int how)
+{
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = get_sock(s);
+    if (sock) {
+        sock->closed = true;
+        pthread_cond_broadcast(&s_cond);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return sock ? 0 : -1;
+}
+
+int lwip_close(int s)
+{
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = get_sock(s);
+    if (sock) {
+        sock->closed = true;
+        sock->used   = false;
+        pthread_cond_broadcast(&s_cond);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return sock ? 0 : -1;
+}
+
+/* ── Test side ──────────────────────────────────────────────────────── */
+
+int host_udp_request(uint16_t port, const void *data, size_t len,
+                     void *reply, size_t cap, int timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    sock_t *sock = NULL;
+    for (int i = 0; i < MAX_SOCKETS; i++) {
+        if (s_socks[i].used && !s_socks[i].closed && s_socks[i].port == port) {
+            sock = &s_socks[i];
+        }
+    }
+    int ret = -1;
+    if (sock && len <= DGRAM_MAX) {
+        while (sock->rx_full && !sock->closed) {
+            if (pthread_cond_timedwait(&s_cond, &s_lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (!sock->rx_full && !sock->closed) {
+            memcpy(sock->rx, data, len);
+            sock->rx_len   = len;
+            sock->rx_full  = true;
+            sock->tx_ready = false;
+            pthread_cond_broadcast(&s_cond);
+            while (!sock->tx_ready && !sock->closed) {
+                if (pthread_cond_timedwait(&s_cond, &s_lock, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+            if (sock->tx_ready) {
+                ret = (int)(sock->tx_len < cap ? sock->tx_len : cap);
+                memcpy(reply, sock->tx, ret);
+                sock->tx_ready = false;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+unsigned host_sockets_open(void)
+{
+    unsigned n = 0;
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < MAX_SOCKETS; i++) {
+        n += s_socks[i].used;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
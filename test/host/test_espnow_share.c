@@ -0,0 +1,303 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * ESP-NOW credential sharing on a simulated radio. The real sender is
+ * run once to record its frame and send schedule. Up to 100 peers then
+ * replay that schedule on one channel of a CSMA/CA medium. Broadcasts
+ * are not acknowledged, so frames that collide are lost. The frames
+ * that get through are handed to a real unprovisioned device while it
+ * sweeps the channels in wifi_prov_start().
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+#include "esp_now.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PEER_CHANNEL HOME_CHANNEL
+
+#define MAX_PEERS    100
+#define MAX_FRAME    250        /* ESP_NOW_MAX_DATA_LEN */
+#define MAX_GAPS     256
+#define SIM_US       ((int64_t)CONFIG_WIFI_PROV_ESPNOW_LISTEN_MS * 1000)
+#define MAX_TX       (MAX_PEERS * 128)
+
+/* 802.11b at 1 Mbps, the ESP-NOW default rate */
+#define SLOT_US      20
+#define DIFS_US      50
+#define CW_MIN       31
+#define PLCP_US      192
+#define MAC_BYTES    43         /* header, action frame and vendor element, FCS */
+
+typedef struct {
+    int64_t due;                /* when the peer wants to send */
+    int64_t start;              /* when it went on air, -1 = still deferred */
+    int     backoff;            /* slots left after the medium went idle */
+} sim_tx_t;
+
+typedef struct {
+    unsigned offered;
+    unsigned delivered;
+    unsigned collided;          /* frames lost in a collision */
+    int64_t  deferred_us;       /* summed wait for a free medium */
+} sim_result_t;
+
+/* Sender capture */
+static uint8_t s_frame[MAX_FRAME];
+static size_t  s_frame_len;
+static int64_t s_gaps[MAX_GAPS];
+static int     s_gap_count;
+static int64_t s_last_tx;
+
+/* Medium */
+static sim_tx_t s_tx[MAX_TX];
+static int64_t  s_heard[MAX_TX];  /* start times of frames that got through */
+static int      s_heard_count;
+
+/* Receiver */
+static int64_t  s_epoch;
+static int      s_next_heard;
+static unsigned s_rx_frames;
+
+/* ── Sender capture ─────────────────────────────────────────────────── */
+
+static void capture_tx(const uint8_t *data, size_t len)
+{
+    int64_t now = esp_timer_get_time();
+    if (s_frame_len == 0 && len <= sizeof(s_frame)) {
+        memcpy(s_frame, data, len);
+        s_frame_len = len;
+    } else if (s_gap_count < MAX_GAPS) {
+        s_gaps[s_gap_count++] = now - s_last_tx;
+    }
+    s_last_tx = now;
+}
+
+static void capture_sender(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    wifi_prov_creds_t creds = { .ssid = HOME_SSID, .password = HOME_PASSWORD,
+                                .authmode = WIFI_AUTH_WPA2_PSK };
+    CHECK(wifi_prov_init() == ESP_OK);
+    CHECK(nvs_store_save(&creds) == ESP_OK);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(wifi_prov_is_connected());
+
+    host_espnow_set_tx(capture_tx);
+    CHECK(wifi_prov_share_credentials(CONFIG_WIFI_PROV_ESPNOW_LISTEN_MS * 4) == ESP_OK);
+    host_espnow_set_tx(NULL);
+
+    /* ESP-NOW the application brought up is still its own afterwards */
+    esp_now_peer_num_t peers;
+    CHECK(esp_now_get_peer_num(&peers) == ESP_ERR_ESPNOW_NOT_INIT);
+    CHECK(esp_now_init() == ESP_OK);
+    CHECK(wifi_prov_share_credentials(CONFIG_WIFI_PROV_ESPNOW_LISTEN_MS / 10) == ESP_OK);
+    CHECK(esp_now_get_peer_num(&peers) == ESP_OK && peers.total_num == 0);
+    CHECK(esp_now_deinit() == ESP_OK);
+
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    CHECK(s_frame_len > 0 && s_gap_count > 8);
+}
+
+/* ── Medium ─────────────────────────────────────────────────────────── */
+
+static int64_t airtime_us(void)
+{
+    return PLCP_US + (int64_t)(MAC_BYTES + s_frame_len) * 8;
+}
+
+/* Every peer replays the captured gaps from its own random phase */
+static int schedule(int peers)
+{
+    int n = 0;
+    for (int p = 0; p < peers; p++) {
+        int g = esp_random() % s_gap_count;
+        int64_t t = esp_random() % s_gaps[g];
+        while (t < SIM_US && n < MAX_TX) {
+            s_tx[n++] = (sim_tx_t){ .due = t, .start = -1 };
+            t += s_gaps[g];
+            g = (g + 1) % s_gap_count;
+        }
+    }
+    return n;
+}
+
+static int by_due(const void *a, const void *b)
+{
+    int64_t d = ((const sim_tx_t *)a)->due - ((const sim_tx_t *)b)->due;
+    return (d > 0) - (d < 0);
+}
+
+/*
+ * CSMA/CA without retries: a frame due on an idle medium goes out at
+ * once; one due while the medium is busy waits for DIFS plus a random
+ * backoff that is frozen while others transmit. Frames starting within
+ * one slot of each other cannot hear each other and collide.
+ */
+static sim_result_t simulate(int peers)
+{
+    int n = schedule(peers);
+    qsort(s_tx, n, sizeof(s_tx[0]), by_due);
+
+    sim_result_t result = { .offered = n };
+    int64_t busy_until = -DIFS_US;
+    int done = 0;               /* [0, done) sent, [done, next) deferred */
+    int next = 0;
+    s_heard_count = 0;
+
+    while (done < n) {
+        int64_t idle_at = busy_until + DIFS_US;
+
+        /* Falling due while the medium is busy: defer with a backoff */
+        while (next < n && s_tx[next].due < idle_at) {
+            s_tx[next++].backoff = esp_random() % (CW_MIN + 1);
+        }
+        int shortest = CW_MIN + 1;
+        for (int i = done; i < next; i++) {
+            shortest = s_tx[i].backoff < shortest ? s_tx[i].backoff : shortest;
+        }
+        int64_t start = shortest <= CW_MIN ? idle_at + (int64_t)shortest * SLOT_US
+                                           : INT64_MAX;
+        /* Falling due on an idle medium: straight on air */
+        if (next < n && s_tx[next].due < start) {
+            start = s_tx[next].due;
+        }
+
+        /* Everyone leaving within this slot: backoff ran out, or just due */
+        int elapsed = (int)((start - idle_at) / SLOT_US);
+        unsigned on_air = 0;
+        for (int i = done; i < next; i++) {
+            s_tx[i].backoff -= elapsed;
+            if (s_tx[i].backoff <= 0) {
+                s_tx[i].start = start;
+                on_air++;
+            }
+        }
+        while (next < n && s_tx[next].due < start + SLOT_US) {
+            s_tx[next++].start = start;
+            on_air++;
+        }
+
+        if (on_air == 1) {
+            s_heard[s_heard_count++] = start;
+            result.delivered++;
+        } else {
+            result.collided += on_air;
+        }
+        busy_until = start + airtime_us();
+
+        /* Move the sent frames out of the deferred range */
+        for (int i = done; i < next; i++) {
+            if (s_tx[i].start >= 0) {
+                result.deferred_us += s_tx[i].start - s_tx[i].due;
+                sim_tx_t t = s_tx[i];
+                s_tx[i] = s_tx[done];
+                s_tx[done++] = t;
+            }
+        }
+    }
+    return result;
+}
+
+/* ── Receiver ───────────────────────────────────────────────────────── */
+
+/* While the receiver waits, hand it what the medium delivered by then */
+static bool deliver_heard(int64_t until_us)
+{
+    while (s_next_heard < s_heard_count) {
+        int64_t at = s_epoch + s_heard[s_next_heard];
+        if (at > until_us) {
+            return false;
+        }
+        s_next_heard++;
+        if (at < esp_timer_get_time() || host_wifi()->channel != PEER_CHANNEL) {
+            continue;           /* missed: listening elsewhere */
+        }
+        host_clock_advance(at - esp_timer_get_time());
+        if (host_espnow_rx(s_frame, s_frame_len)) {
+            s_rx_frames++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Time from wifi_prov_start() to connected with the shared credentials */
+static int64_t provision_peer(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    s_next_heard = 0;
+    s_rx_frames  = 0;
+    s_epoch      = esp_timer_get_time();
+
+    host_clock_skip_waits(true, deliver_heard);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    int64_t took = esp_timer_get_time() - s_epoch;
+    host_clock_skip_waits(true, NULL);
+
+    CHECK(wifi_prov_is_connected() && host_httpd_running() == 0);
+    CHECK(s_rx_frames > 0);
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    return took;
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "espnow_share");
+
+    host_clock_skip_waits(true, NULL);
+    host_random_seed(0x5eed);
+    host_fixture_init();
+
+    capture_sender();
+
+    int64_t gaps = 0;
+    for (int i = 0; i < s_gap_count; i++) {
+        gaps += s_gaps[i];
+    }
+    bench_metric("sender interval", gaps / s_gap_count / 1e3, "ms");
+    bench_metric("frame airtime",   airtime_us() / 1e3, "ms");
+
+    static const int peer_counts[] = { 1, 10, 50, MAX_PEERS };
+    double last_throughput = 0;
+
+    for (size_t i = 0; i < sizeof(peer_counts) / sizeof(peer_counts[0]); i++) {
+        int peers = peer_counts[i];
+        sim_result_t r = simulate(peers);
+        int64_t took = provision_peer();
+
+        double loss = (double)r.collided / r.offered;
+        double throughput = r.delivered / (SIM_US / 1e6);
+        char name[48];
+
+        CHECK(r.delivered + r.collided == r.offered);
+        CHECK(peers > 1 || r.collided == 0);
+        /* Past saturation collisions eat the extra load, not the goodput */
+        CHECK(throughput > last_throughput);
+        /* However crowded, a listener is provisioned before its portal */
+        CHECK(took < SIM_US);
+        last_throughput = throughput;
+
+        snprintf(name, sizeof(name), "%3d peers: delivered", peers);
+        bench_metric(name, throughput, "frames/s");
+        snprintf(name, sizeof(name), "%3d peers: collided", peers);
+        bench_metric(name, loss * 100, "%");
+        snprintf(name, sizeof(name), "%3d peers: medium wait", peers);
+        bench_metric(name, r.deferred_us / 1e3 / r.offered, "ms/frame");
+        snprintf(name, sizeof(name), "%3d peers: receiver provisioned", peers);
+        bench_metric(name, took / 1e6, "s");
+    }
+
+    return bench_finish();
+}
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Start/stop stress: a thousand cycles through the four ways a start
+ * can go (no credentials, stored ones that work, stored ones that fail,
+ * provisioning through the portal), each followed by a stop. Every
+ * round of four has to leave the heap, tasks, sockets, servers and
+ * event handlers exactly where the first one left them, and cycles may
+ * not get slower as they pile up.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_WIFI_PROV_HTTPS
+#define PORTAL_PORT CONFIG_WIFI_PROV_HTTPS_PORT
+#else
+#define PORTAL_PORT CONFIG_WIFI_PROV_HTTP_PORT
+#endif
+
+#define CYCLES          1000
+#define WARMUP_ROUNDS   3       /* event loop, NVS pages, scan cache settle */
+#define CYCLE_BUDGET_MS 250     /* wall time, generous for loaded CI hosts */
+
+typedef enum {
+    CYCLE_UNPROVISIONED,
+    CYCLE_STORED_OK,
+    CYCLE_STORED_FAIL,
+    CYCLE_PORTAL_SAVE,
+    CYCLE_KINDS,
+} cycle_kind_t;
+
+static const char *const KIND_NAMES[CYCLE_KINDS] = {
+    "unprovisioned", "stored ok", "stored fail", "portal save",
+};
+
+static host_http_resp_t s_resp;
+static int64_t          s_ns[CYCLES];
+static int64_t          s_ref_ns[CYCLES / CYCLE_KINDS];
+
+static void store(const char *password)
+{
+    wifi_prov_creds_t creds = { .ssid = HOME_SSID, .authmode = WIFI_AUTH_WPA2_PSK };
+    strcpy(creds.password, password);
+    CHECK(nvs_store_save(&creds) == ESP_OK);
+}
+
+static bool run_cycle(cycle_kind_t kind)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    bool ok = true;
+
+    switch (kind) {
+    case CYCLE_UNPROVISIONED:
+    case CYCLE_PORTAL_SAVE:
+        ok &= wifi_prov_erase_credentials() == ESP_OK;
+        break;
+    case CYCLE_STORED_OK:
+        store(HOME_PASSWORD);
+        break;
+    case CYCLE_STORED_FAIL:
+        store("wrong horse battery");
+        break;
+    default:
+        break;
+    }
+
+    ok &= wifi_prov_start(&config) == ESP_OK;
+    bool connected = kind == CYCLE_STORED_OK;
+    ok &= wifi_prov_is_connected() == connected;
+    ok &= (host_httpd_running() > 0) == !connected;
+
+    if (kind == CYCLE_PORTAL_SAVE) {
+        host_http_request(PORTAL_PORT, HTTP_POST, "/save", NULL,
+                          "ssid=HomeNet&password=correct+horse+battery", &s_resp);
+        ok &= wifi_prov_wait_for_connection(0) == ESP_OK;
+        ok &= host_httpd_running() == 0 && host_sockets_open() == 0;
+    }
+
+    ok &= wifi_prov_stop() == ESP_OK;
+    ok &= !wifi_prov_is_connected();
+    ok &= host_httpd_running() == 0 && host_sockets_open() == 0;
+    ok &= host_tasks_alive() == 0;
+    ok &= !host_wifi()->initialized;
+    return ok;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* A fixed amount of work to tell a slower host from slower cycles */
+static int64_t time_reference(void)
+{
+    uint8_t pmk[WIFI_PMK_LEN];
+    int64_t t0 = bench_now_ns();
+    crypto_wpa_pmk(HOME_SSID, HOME_PASSWORD, pmk);
+    return bench_now_ns() - t0;
+}
+
+/*
+ * Rounds in [start, start + count) by their fastest cycle of each kind,
+ * relative to the fastest reference run among them
+ */
+static double fastest_round(unsigned start, unsigned count)
+{
+    int64_t fastest[CYCLE_KINDS] = {0};
+    int64_t reference = 0;
+    for (unsigned i = start; i < start + count; i++) {
+        int64_t *f = &fastest[i % CYCLE_KINDS];
+        if (*f == 0 || s_ns[i] < *f) {
+            *f = s_ns[i];
+        }
+        int64_t ref = s_ref_ns[i / CYCLE_KINDS];
+        if (reference == 0 || ref < reference) {
+            reference = ref;
+        }
+    }
+    int64_t sum = 0;
+    for (int kind = 0; kind < CYCLE_KINDS; kind++) {
+        sum += fastest[kind];
+    }
+    return (double)sum / (double)reference;
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "lifecycle");
+
+    host_clock_skip_waits(true, NULL);
+    host_fixture_init();
+
+    /* The first rounds create what lives on for good (event loop, NVS) */
+    unsigned failed = 0;
+    for (int round = 0; round < WARMUP_ROUNDS; round++) {
+        for (int kind = 0; kind < CYCLE_KINDS; kind++) {
+            failed += !run_cycle(kind);
+        }
+    }
+    size_t   heap_base     = host_heap_used();
+    unsigned handlers_base = host_event_handlers();
+
+    unsigned cycles = bench_iters(CYCLES);
+    int64_t *ns = s_ns;
+    int64_t  kind_max[CYCLE_KINDS] = {0};
+    long     heap_drift_max = 0;
+    unsigned handler_drift  = 0;
+
+    for (unsigned i = 0; i < cycles; i++) {
+        cycle_kind_t kind = (cycle_kind_t)(i % CYCLE_KINDS);
+        int64_t t0 = bench_now_ns();
+        failed += !run_cycle(kind);
+        ns[i] = bench_now_ns() - t0;
+        if (ns[i] > kind_max[kind]) {
+            kind_max[kind] = ns[i];
+        }
+
+        if (kind == CYCLE_KINDS - 1) {
+            s_ref_ns[i / CYCLE_KINDS] = time_reference();
+            long drift = (long)host_heap_used() - (long)heap_base;
+            if (labs(drift) > labs(heap_drift_max)) {
+                heap_drift_max = drift;
+            }
+            handler_drift += host_event_handlers() != handlers_base;
+        }
+    }
+
+    long heap_growth = (long)host_heap_used() - (long)heap_base;
+    CHECK(failed == 0);
+    CHECK(heap_growth == 0);
+    CHECK(heap_drift_max == 0);
+    CHECK(handler_drift == 0);
+
+    /*
+     * No slowdown as cycles accumulate: the last tenth against the first,
+     * each by its fastest cycle of every kind and in units of a reference
+     * computation, so host load and clock changes cancel out
+     */
+    unsigned tenth = cycles / 10;
+    double first = fastest_round(0, tenth);
+    double last  = fastest_round(cycles - tenth, tenth);
+    CHECK(last <= first * 1.5);
+
+    int64_t max = 0;
+    for (int kind = 0; kind < CYCLE_KINDS; kind++) {
+        max = kind_max[kind] > max ? kind_max[kind] : max;
+    }
+    CHECK(max < (int64_t)CYCLE_BUDGET_MS * 1000000);
+
+    qsort(ns, cycles, sizeof(*ns), cmp_i64);
+    bench_metric("cycles",             cycles, "");
+    bench_metric("cycle median",       ns[cycles / 2] / 1e3, "us");
+    bench_metric("cycle p99",          ns[cycles * 99 / 100] / 1e3, "us");
+    bench_metric("cycle max",          max / 1e3, "us");
+    for (int kind = 0; kind < CYCLE_KINDS; kind++) {
+        char name[48];
+        snprintf(name, sizeof(name), "max %s", KIND_NAMES[kind]);
+        bench_metric(name, kind_max[kind] / 1e3, "us");
+    }
+    bench_metric("heap after warm-up", heap_base, "bytes");
+    bench_metric("heap growth",        heap_growth, "bytes");
+    bench_metric("last/first tenth",   last / first, "x");
+
+    host_http_resp_free(&s_resp);
+    return bench_finish();
+}
@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Portal teardown: once credentials arrive through the portal, every
+ * byte and resource it took has to come back. The heap after connecting
+ * through the portal is held against connecting with stored credentials,
+ * which never brings the portal up, and against its level before start.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_WIFI_PROV_HTTPS
+#define PORTAL_PORT CONFIG_WIFI_PROV_HTTPS_PORT
+#else
+#define PORTAL_PORT CONFIG_WIFI_PROV_HTTP_PORT
+#endif
+
+#define ROUNDS        3
+#define DISPOSE_SLACK 64    /* bytes the two ways to connect may differ by */
+
+static host_http_resp_t s_resp;
+
+static void get(const char *uri)
+{
+    host_http_request(PORTAL_PORT, HTTP_GET, uri,
+                      "Accept-Encoding: gzip\r\n", NULL, &s_resp);
+}
+
+/* Connected through the portal, the way a phone would do it */
+static void provision_via_portal(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(host_httpd_running() > 0);
+
+    get("/");
+    get("/config");
+    get("/scan");
+    host_http_request(PORTAL_PORT, HTTP_POST, "/save", NULL,
+                      "ssid=HomeNet&password=correct+horse+battery", &s_resp);
+    CHECK(wifi_prov_wait_for_connection(0) == ESP_OK);
+}
+
+/* Connected straight from stored credentials: the portal never runs */
+static void connect_stored(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    wifi_prov_creds_t creds = { .ssid = HOME_SSID, .authmode = WIFI_AUTH_WPA2_PSK };
+    strcpy(creds.password, HOME_PASSWORD);
+    CHECK(nvs_store_save(&creds) == ESP_OK);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(wifi_prov_is_connected() && host_httpd_running() == 0);
+}
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "portal_dispose");
+
+    host_clock_skip_waits(true, NULL);
+    host_fixture_init();
+
+    /* Once through both paths for what lives on for good (event loop, NVS) */
+    provision_via_portal();
+    CHECK(wifi_prov_stop() == ESP_OK);
+    connect_stored();
+    CHECK(wifi_prov_stop() == ESP_OK);
+
+    /* Reference: connected without a portal */
+    connect_stored();
+    size_t   direct       = host_heap_used();
+    unsigned direct_tasks = host_tasks_alive();
+    CHECK(wifi_prov_stop() == ESP_OK);
+
+    long     worst_delta  = 0;
+    size_t   peak_above   = 0;
+    int64_t  provision_ns = 0;
+    unsigned leftovers    = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        size_t before = host_heap_used();
+        host_heap_peak_reset();
+
+        int64_t t0 = bench_now_ns();
+        provision_via_portal();
+        int64_t t1 = bench_now_ns();
+        if (round == 0 || t1 - t0 < provision_ns) {
+            provision_ns = t1 - t0;
+        }
+
+        /* Nothing of the portal may remain */
+        leftovers += host_httpd_running() != 0;
+        leftovers += host_sockets_open() != 0;
+        leftovers += host_tasks_alive() != direct_tasks;
+        leftovers += esp_netif_get_handle_from_ifkey("WIFI_AP_DEF") != NULL;
+        leftovers += host_wifi()->mode != WIFI_MODE_STA;
+        CHECK(host_wifi()->associated);
+
+        long delta = (long)host_heap_used() - (long)direct;
+        if (labs(delta) > labs(worst_delta)) {
+            worst_delta = delta;
+        }
+        size_t peak = host_heap_peak() - before;
+        peak_above  = peak > peak_above ? peak : peak_above;
+
+        CHECK(wifi_prov_stop() == ESP_OK);
+        CHECK(host_heap_used() == before);
+    }
+
+    CHECK(leftovers == 0);
+    CHECK(labs(worst_delta) <= DISPOSE_SLACK);
+    CHECK(peak_above > 0);
+
+    /* The channel of a network that failed does not stick to later portals */
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    wifi_prov_creds_t  creds  = { .ssid = HOME_SSID, .password = "wrong horse battery",
+                                  .authmode = WIFI_AUTH_WPA2_PSK };
+    wifi_config_t      ap;
+    CHECK(nvs_store_save(&creds) == ESP_OK);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(esp_wifi_get_config(WIFI_IF_AP, &ap) == ESP_OK && ap.ap.channel == HOME_CHANNEL);
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(esp_wifi_get_config(WIFI_IF_AP, &ap) == ESP_OK && ap.ap.channel != HOME_CHANNEL);
+    CHECK(wifi_prov_stop() == ESP_OK);
+
+#if CONFIG_WIFI_PROV_STATIC_ALLOC
+    /* A handler freeing after the portal stopped takes the arena with it */
+    size_t before = host_heap_used();
+    CHECK(arena_init(CONFIG_WIFI_PROV_ARENA_SIZE) == ESP_OK);
+    void *late = arena_alloc(64);
+    arena_release();
+    CHECK(host_heap_used() > before);
+    arena_free(late);
+    CHECK(host_heap_used() == before);
+#endif
+
+    bench_metric("connected, no portal",        direct, "bytes");
+    bench_metric("portal peak above start",     peak_above, "bytes");
+    bench_metric("after dispose vs. no portal", worst_delta, "bytes");
+    bench_metric("portal to connected",         provision_ns / 1e6, "ms");
+
+    host_http_resp_free(&s_resp);
+    return bench_finish();
+}
@@ -0,0 +1,252 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michael Teeuw
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Credential pipeline through a loopback transport: registered in place
+ * of the captive portal, started and stopped by wifi_prov_start() and
+ * the hand-off, and fed credentials by the test the way the portal and
+ * BLE transports feed what a client sent. Checks validation, the trial
+ * connect, persistence and the hand-off to the orchestrator. With
+ * CONFIG_WIFI_PROV_TRANSPORT_BLE the same is driven through the GATT
+ * service as a connected phone would.
+ */
+
+#include "bench.h"
+#include "host_fake.h"
+#include "host_fixture.h"
+#include "wifi_provisioner.h"
+#include "wifi_prov_internal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static char     s_posted[33];
+static unsigned s_posts;
+
+static void on_posted(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    strncpy(s_posted, data, sizeof(s_posted) - 1);
+    s_posts++;
+}
+
+static bool stored(const char *ssid, const char *password)
+{
+    wifi_prov_creds_t creds = {0};
+    return nvs_store_load(&creds) == ESP_OK &&
+           strcmp(creds.ssid, ssid) == 0 && strcmp(creds.password, password) == 0;
+}
+
+/* ── Loopback transport ─────────────────────────────────────────────── */
+
+static unsigned s_starts;
+static unsigned s_stops;
+
+/* Brings up what the BLE transport does: the STA side and a scan */
+static esp_err_t loopback_start(const wifi_prov_config_t *config)
+{
+    s_starts++;
+    wifi_sta_netif();
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    esp_wifi_start();
+    wifi_scan_run(0);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_stop(void)
+{
+    s_stops++;
+    return ESP_OK;
+}
+
+static const prov_transport_t s_loopback = {
+    .name  = "loopback",
+    .start = loopback_start,
+    .stop  = loopback_stop,
+};
+
+/* What a client sent, handled as every transport handles it */
+static esp_err_t loopback_receive(const char *ssid, const char *password, uint8_t channel)
+{
+    wifi_prov_creds_t creds = { .channel = channel };
+    strncpy(creds.ssid, ssid, sizeof(creds.ssid) - 1);
+    strncpy(creds.password, password, sizeof(creds.password) - 1);
+    esp_err_t err = provision_apply(&creds);
+    if (err == ESP_OK) {
+        provision_complete(&creds);
+    }
+    return err;
+}
+
+static void test_loopback(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    CHECK(provision_register_transport(WIFI_PROV_TRANSPORT_HTTP, &s_loopback) == ESP_OK);
+    CHECK(esp_event_handler_register(WIFI_PROV_EVENT, WIFI_PROV_EVENT_CREDENTIALS_SET,
+                                     on_posted, NULL) == ESP_OK);
+
+    s_starts = s_stops = s_posts = 0;
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(s_starts == 1 && s_stops == 0);
+    CHECK(host_httpd_running() == 0 && host_wifi()->mode == WIFI_MODE_STA);
+
+    /* Malformed input never reaches the radio */
+    unsigned connects = host_wifi()->connects;
+    CHECK(loopback_receive("", HOME_PASSWORD, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(loopback_receive(HOME_SSID, "short", 0) == ESP_ERR_INVALID_ARG);
+    CHECK(loopback_receive(HOME_SSID, HOME_PASSWORD, 15) == ESP_ERR_INVALID_ARG);
+    CHECK(host_wifi()->connects == connects);
+
+    /* A failed trial connect keeps nothing, and the transport running */
+    CHECK(loopback_receive(HOME_SSID, "wrong password", 0) != ESP_OK);
+    CHECK(host_wifi()->connects > connects);
+    CHECK(!stored(HOME_SSID, "wrong password"));
+    CHECK(s_posts == 0 && s_stops == 0 && !wifi_prov_is_connected());
+
+    /* Connected, saved and handed off: the orchestrator stops the transport */
+    int64_t t0 = bench_now_ns();
+    CHECK(loopback_receive(HOME_SSID, HOME_PASSWORD, 0) == ESP_OK);
+    int64_t t1 = bench_now_ns();
+    CHECK(stored(HOME_SSID, HOME_PASSWORD));
+    CHECK(host_wifi()->associated);
+    CHECK(s_posts == 1 && strcmp(s_posted, HOME_SSID) == 0);
+    CHECK(wifi_prov_wait_for_connection(0) == ESP_OK);
+    CHECK(s_starts == 1 && s_stops == 1);
+
+    CHECK(esp_event_handler_unregister(WIFI_PROV_EVENT, WIFI_PROV_EVENT_CREDENTIALS_SET,
+                                       on_posted) == ESP_OK);
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(s_stops == 1);
+    CHECK(provision_register_transport(WIFI_PROV_TRANSPORT_HTTP,
+                                       &prov_transport_http) == ESP_OK);
+
+    bench_metric("loopback apply", (t1 - t0) / 1e6, "ms");
+}
+
+/* ── BLE transport ──────────────────────────────────────────────────── */
+
+#if CONFIG_WIFI_PROV_TRANSPORT_BLE
+
+#define UUID_BASE(id) BLE_UUID128_INIT(0x9e, 0x4b, 0x2d, 0x61, 0x87, 0x3c, 0x5f, 0xa0, \
+                                       0x41, 0x4e, 0xd2, 0x7b, id, 0x00, 0x1e, 0x5a)
+
+enum { STATUS_IDLE, STATUS_CONNECTING, STATUS_CONNECTED, STATUS_FAILED };
+
+static const ble_uuid128_t s_ssid_uuid     = UUID_BASE(0x02);
+static const ble_uuid128_t s_password_uuid = UUID_BASE(0x03);
+static const ble_uuid128_t s_apply_uuid    = UUID_BASE(0x04);
+static const ble_uuid128_t s_status_uuid   = UUID_BASE(0x05);
+
+static int write_chr(const ble_uuid128_t *uuid, const void *data, uint16_t len)
+{
+    return host_ble_access(uuid, BLE_GATT_ACCESS_OP_WRITE_CHR, data, len, NULL, NULL);
+}
+
+static int write_creds(const char *ssid, const char *password)
+{
+    static const uint8_t go = 0x01;
+    int rc = write_chr(&s_ssid_uuid, ssid, strlen(ssid));
+    rc = rc ? rc : write_chr(&s_password_uuid, password, strlen(password));
+    return rc ? rc : write_chr(&s_apply_uuid, &go, sizeof(go));
+}
+
+/*
+ * The NimBLE host runs on its own thread, outside what the skipped clock
+ * can see: give it real time in small steps instead of jumping ahead.
+ */
+static bool let_host_run(int64_t until_us)
+{
+    int64_t left = until_us - esp_timer_get_time();
+    if (left <= 0) {
+        return false;
+    }
+    usleep(200);
+    host_clock_advance(left < 10000 ? left : 10000);
+    return true;
+}
+
+/* The host task syncs and starts advertising after start returned */
+static bool wait_advertising(void)
+{
+    for (int i = 0; i < 100 && !host_ble_running(); i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return host_ble_running();
+}
+
+/* Poll the status characteristic until the trial connect settled */
+static uint8_t wait_status(void)
+{
+    uint8_t status = STATUS_IDLE;
+    for (int i = 0; i < 1000; i++) {
+        uint16_t len = sizeof(status);
+        if (host_ble_access(&s_status_uuid, BLE_GATT_ACCESS_OP_READ_CHR,
+                            NULL, 0, &status, &len) != 0) {
+            break;
+        }
+        if (status == STATUS_CONNECTED || status == STATUS_FAILED) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return status;
+}
+
+static void test_ble(void)
+{
+    wifi_prov_config_t config = WIFI_PROV_DEFAULT_CONFIG();
+    config.transport = WIFI_PROV_TRANSPORT_BLE;
+    CHECK(wifi_prov_erase_credentials() == ESP_OK);
+    unsigned tasks = host_tasks_alive();
+    host_clock_skip_waits(true, let_host_run);
+
+    CHECK(wifi_prov_start(&config) == ESP_OK);
+    CHECK(wait_advertising());
+    CHECK(host_httpd_running() == 0);
+    CHECK(host_wifi()->mode == WIFI_MODE_STA);
+
+    unsigned notified = host_ble_notifications();
+    CHECK(write_creds(HOME_SSID, "wrong password") == 0);
+    CHECK(wait_status() == STATUS_FAILED);
+    CHECK(!stored(HOME_SSID, "wrong password"));
+    CHECK(host_ble_running() && !wifi_prov_is_connected());
+
+    int64_t t0 = bench_now_ns();
+    CHECK(write_creds(HOME_SSID, HOME_PASSWORD) == 0);
+    CHECK(wifi_prov_wait_for_connection(pdMS_TO_TICKS(10000)) == ESP_OK);
+    int64_t t1 = bench_now_ns();
+
+    /* connecting, failed, connecting, connected */
+    CHECK(host_ble_notifications() - notified == 4);
+    CHECK(stored(HOME_SSID, HOME_PASSWORD));
+    CHECK(!host_ble_running());
+    CHECK(host_wifi()->associated);
+
+    CHECK(wifi_prov_stop() == ESP_OK);
+    CHECK(host_tasks_alive() == tasks);
+    host_clock_skip_waits(true, NULL);
+
+    bench_metric("BLE apply to connected", (t1 - t0) / 1e6, "ms");
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    bench_init(argc, argv, "provision");
+
+    host_clock_skip_waits(true, NULL);
+    host_fixture_init();
+
+    test_loopback();
+#if CONFIG_WIFI_PROV_TRANSPORT_BLE
+    test_ble();
+#endif
+
+    return bench_finish();
+}
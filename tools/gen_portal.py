@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2026 Michael Teeuw
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Build the per-locale portal pages: translate src/html/portal.html with
+# src/html/strings.json, minify, and emit each gzipped and plain as a C
+# source with a two-letter language code lookup table (see portal_asset_t).
+
+import argparse
+import gzip
+import json
+import re
+import sys
+
+
+# Only marked text is translated: the content of elements carrying a bare
+# data-i18n attribute, and string literals wrapped in t('…') in the script
+ELEMENT = re.compile(r'<(\w+)([^>]*?) data-i18n>(.*?)</\1>', re.S)
+SCRIPT = re.compile(r"\bt\('([^'\\]*)'\)")
+
+
+def translate(html, strings, locale):
+    used = set()
+
+    def lookup(en, in_script):
+        if en not in strings:
+            sys.exit(f'gen_portal: "{en}" is marked but has no entry in strings.json')
+        used.add(en)
+        if locale == 'en':
+            return en
+        text = strings[en].get(locale)
+        if text is None:
+            sys.exit(f'gen_portal: no "{locale}" translation for "{en}"')
+        if in_script and ("'" in text or '\\' in text):
+            sys.exit(f'gen_portal: "{text}" ends up in a JS string, avoid \' and \\')
+        return text
+
+    html = ELEMENT.sub(lambda m: f'<{m[1]}{m[2]}>{lookup(m[3], False)}</{m[1]}>', html)
+    html = SCRIPT.sub(lambda m: "'" + lookup(m[1], True) + "'", html)
+
+    for en in strings:
+        if en not in used:
+            sys.exit(f'gen_portal: "{en}" is not marked in portal.html')
+    return html.replace('<html>', f'<html lang="{locale}">', 1)
+
+
+def minify(html):
+    # Indentation and blank lines only: the script relies on newlines (ASI)
+    lines = (line.strip() for line in html.splitlines())
+    html = '\n'.join(line for line in lines if line)
+
+    def squash_css(m):
+        css = re.sub(r'\s*([{}:;,])\s*', r'\1', m.group(2))
+        return m.group(1) + css.replace(';}', '}') + m.group(3)
+
+    return re.sub(r'(<style>)(.*?)(</style>)', squash_css, html, flags=re.S)
+
+
+def c_array(name, data):
+    rows = (', '.join(f'0x{b:02x}' for b in data[i:i + 16])
+            for i in range(0, len(data), 16))
+    body = ',\n    '.join(rows)
+    return f'static const uint8_t {name}[] = {{\n    {body}\n}};\n'
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--html', required=True)
+    parser.add_argument('--strings', required=True)
+    parser.add_argument('--locales', required=True,
+                        help='space separated two-letter codes, the first is the default')
+    parser.add_argument('--out', required=True)
+    args = parser.parse_args()
+
+    with open(args.html, encoding='utf-8') as f:
+        html = f.read()
+    with open(args.strings, encoding='utf-8') as f:
+        strings = json.load(f)
+
+    locales = args.locales.split()
+    if not locales:
+        sys.exit('gen_portal: no locales given')
+    for locale in locales:
+        if not re.fullmatch(r'[a-z]{2}', locale):
+            sys.exit(f'gen_portal: "{locale}" is not a two-letter language code')
+
+    out = [
+        '/* Generated by tools/gen_portal.py from src/html – do not edit */\n\n',
+        '#include "wifi_prov_internal.h"\n\n',
+    ]
+    index = {}
+    for i, locale in enumerate(locales):
+        page = minify(translate(html, strings, locale)).encode('utf-8')
+        # mtime=0 keeps the output reproducible
+        out.append(c_array(f'portal_{locale}', gzip.compress(page, 9, mtime=0)) + '\n')
+        # The same page for clients that do not take gzip
+        out.append(c_array(f'portal_{locale}_plain', page) + '\n')
+        index[(ord(locale[0]) - ord('a')) * 26 + ord(locale[1]) - ord('a')] = i + 1
+
+    out.append('const portal_asset_t portal_assets[] = {\n')
+    out += [f'    {{ "{l}", portal_{l}, sizeof(portal_{l}), '
+            f'portal_{l}_plain, sizeof(portal_{l}_plain) }},\n' for l in locales]
+    out.append('};\n')
+    out.append(f'const size_t portal_asset_count = {len(locales)};\n\n')
+
+    out.append('const uint8_t portal_locale_index[26 * 26] = {\n')
+    out += [f'    [{k}] = {v}, /* {locales[v - 1]} */\n' for k, v in sorted(index.items())]
+    out.append('};\n')
+
+    with open(args.out, 'w', encoding='utf-8') as f:
+        f.write(''.join(out))
+
+
+if __name__ == '__main__':
+    main()